@@ -66,6 +66,29 @@ typedef enum {
   COAP_COSE,
 } coap_memory_tag_t;
 
+/**
+ * Usage of one fixed-size pool of coap_malloc_type() (COAP_MEM_POOL).
+ */
+typedef struct coap_mem_pool_stats_t {
+  const char *name;         /**< Objects in the pool, e.g. "pdu" */
+  size_t block_size;        /**< Bytes per block */
+  unsigned int blocks;      /**< Blocks in the pool */
+  unsigned int used;        /**< Blocks currently allocated */
+  unsigned int high_water;  /**< Most blocks allocated at the same time */
+  unsigned int failures;    /**< Requests served by malloc(): pool empty or
+                                 request too large */
+} coap_mem_pool_stats_t;
+
+/**
+ * Copies the counters of the fixed-size pools into @p stats.
+ *
+ * @param stats Array for the counters.
+ * @param count Number of entries in @p stats.
+ * @return      Number of pools copied, 0 if libcoap is built without
+ *              COAP_MEM_POOL.
+ */
+unsigned int coap_mem_pool_stats(coap_mem_pool_stats_t *stats, unsigned int count);
+
 #ifndef WITH_LWIP
 
 /**
@@ -41,8 +41,19 @@ struct coap_queue_t {
   coap_session_t *session;      /**< the CoAP session */
   coap_mid_t id;                /**< CoAP message id */
   coap_pdu_t *pdu;              /**< the CoAP PDU to send */
+#if COAP_SENDQUEUE_HEAP
+  size_t heap_index;            /**< position + 1 in the sendqueue heap,
+                                 *    0 if not in the sendqueue */
+#endif /* COAP_SENDQUEUE_HEAP */
 };
 
+#if COAP_SENDQUEUE_HEAP && COAP_MEM_POOL
+#ifndef COAP_SENDQUEUE_HEAP_FIXED
+/* Sendqueue heap entries in the context, the default number of nodes of the pool */
+#define COAP_SENDQUEUE_HEAP_FIXED (32U)
+#endif /* COAP_SENDQUEUE_HEAP_FIXED */
+#endif /* COAP_SENDQUEUE_HEAP && COAP_MEM_POOL */
+
 /**
  * The CoAP stack's global state is stored in a coap_context_t object.
  */
@@ -71,6 +82,18 @@ struct coap_context_t {
    * to sendqueue_basetime. */
   coap_tick_t sendqueue_basetime;
   coap_queue_t *sendqueue;
+#if COAP_SENDQUEUE_HEAP
+  /**
+   * Binary min-heap ordered by t, every t is relative to
+   * sendqueue_basetime. sendqueue points to sendqueue_heap[0]. */
+  coap_queue_t **sendqueue_heap;
+  size_t sendqueue_count;         /**< nodes in sendqueue_heap */
+  size_t sendqueue_size;          /**< allocated entries of sendqueue_heap */
+#if COAP_MEM_POOL
+  /** First entries of sendqueue_heap, only larger queues are allocated */
+  coap_queue_t *sendqueue_fixed[COAP_SENDQUEUE_HEAP_FIXED];
+#endif /* COAP_MEM_POOL */
+#endif /* COAP_SENDQUEUE_HEAP */
 #if COAP_SERVER_SUPPORT
   coap_endpoint_t *endpoint;      /**< the endpoints used for listening  */
 #endif /* COAP_SERVER_SUPPORT */
@@ -233,6 +256,18 @@ coap_queue_t *coap_new_node(void);
  */
 unsigned int coap_adjust_basetime(coap_context_t *ctx, coap_tick_t now);
 
+/**
+ * Returns the first node of @p session in the sendqueue of @p context,
+ * without removing it.
+ *
+ * @param context The CoAP context.
+ * @param session The session to look for.
+ *
+ * @return The node, or @c NULL if @p session has nothing queued.
+ */
+coap_queue_t *coap_find_session_node(coap_context_t *context,
+                                     coap_session_t *session);
+
 /**
  * Returns the next pdu to send without removing from sendqeue.
  */
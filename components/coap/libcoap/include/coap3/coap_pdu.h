@@ -512,6 +512,102 @@ int coap_add_data(coap_pdu_t *pdu,
  */
 uint8_t *coap_add_data_after(coap_pdu_t *pdu, size_t len);
 
+#ifndef COAP_PDU_BUILDER_MAX_OPTIONS
+#define COAP_PDU_BUILDER_MAX_OPTIONS 16
+#endif /* COAP_PDU_BUILDER_MAX_OPTIONS */
+
+/**
+ * Collects token, options and payload of a PDU in any order, so that
+ * coap_pdu_builder_build() can allocate the PDU with its exact size and
+ * encode everything in a single pass, without moving options around as
+ * coap_insert_option() does or growing the buffer as coap_add_option() does.
+ *
+ * The builder only references the token, option values and payload, they
+ * must stay valid until coap_pdu_builder_build() returns.
+ */
+typedef struct coap_pdu_builder_t {
+  coap_pdu_type_t type;
+  coap_pdu_code_t code;
+  const uint8_t *token;
+  size_t token_length;
+  const uint8_t *data;          /**< payload, NULL to reserve only */
+  size_t data_length;
+  size_t option_count;
+  int failed;                   /**< set if an option did not fit */
+  struct {
+    coap_option_num_t number;
+    size_t length;
+    const uint8_t *value;
+  } options[COAP_PDU_BUILDER_MAX_OPTIONS];
+} coap_pdu_builder_t;
+
+/**
+ * Starts a new PDU in @p builder.
+ *
+ * @param builder The builder.
+ * @param type    The type of the PDU.
+ * @param code    The code of the PDU.
+ */
+void coap_pdu_builder_init(coap_pdu_builder_t *builder, coap_pdu_type_t type,
+                           coap_pdu_code_t code);
+
+/**
+ * Sets the token of the PDU in @p builder.
+ *
+ * @param builder The builder.
+ * @param len     The length of the token.
+ * @param data    The token.
+ *
+ * @return @c 1 if success, else @c 0 if the token is too large.
+ */
+int coap_pdu_builder_add_token(coap_pdu_builder_t *builder, size_t len,
+                               const uint8_t *data);
+
+/**
+ * Adds an option to the PDU in @p builder. Options may be added in any
+ * order, instances of the same option keep the order they were added in.
+ *
+ * @param builder The builder.
+ * @param number  The option number.
+ * @param len     The length of the option value.
+ * @param data    The option value.
+ *
+ * @return @c 1 if success, else @c 0 if there are already
+ *         COAP_PDU_BUILDER_MAX_OPTIONS options.
+ */
+int coap_pdu_builder_add_option(coap_pdu_builder_t *builder,
+                                coap_option_num_t number, size_t len,
+                                const uint8_t *data);
+
+/**
+ * Sets the payload of the PDU in @p builder.
+ *
+ * @param builder The builder.
+ * @param len     The length of the payload.
+ * @param data    The payload, or @c NULL to only reserve @p len bytes, which
+ *                are filled in through the @p payload returned by
+ *                coap_pdu_builder_build().
+ */
+void coap_pdu_builder_add_data(coap_pdu_builder_t *builder, size_t len,
+                               const uint8_t *data);
+
+/**
+ * Creates the PDU described by @p builder with one allocation of the exact
+ * size. The options are sorted once, then token, options and payload marker
+ * are encoded in a single pass. The header is encoded when the PDU is sent.
+ *
+ * @param builder  The builder, its options are sorted.
+ * @param mid      The message id.
+ * @param max_size The maximum size of the PDU (e.g.
+ *                 coap_session_max_pdu_size()), @c 0 for no limit.
+ * @param payload  If not @c NULL, returns where the payload starts, or
+ *                 @c NULL if there is no payload.
+ *
+ * @return The new PDU or @c NULL on error.
+ */
+coap_pdu_t *coap_pdu_builder_build(coap_pdu_builder_t *builder, coap_mid_t mid,
+                                   size_t max_size, uint8_t **payload);
+
 /**
  * Retrieves the length and data pointer of specified PDU. Returns 0 on error or
  * 1 if *len and *data have correct values. Note that these values are destroyed
@@ -94,6 +94,11 @@
 #define COAP_PDU_MAX_UDP_HEADER_SIZE 4
 #define COAP_PDU_MAX_TCP_HEADER_SIZE 6
 
+#if COAP_OPTION_INDEX
+/* Option numbers below this are indexed by coap_pdu_parse_opt() */
+#define COAP_OPTION_INDEX_SIZE 64
+#endif /* COAP_OPTION_INDEX */
+
 /**
  * structure for CoAP PDUs
  *
@@ -156,8 +161,30 @@ struct coap_pdu_t {
   coap_lg_xmit_t *lg_xmit;  /**< Holds ptr to lg_xmit if sending a set of
                                  blocks */
   coap_session_t *session;  /**< Session responsible for PDU or NULL */
+#if COAP_OPTION_INDEX
+  size_t opt_index_size;    /**< used_size when the index was built, 0 if
+                                 there is no valid index */
+  uint16_t opt_index[COAP_OPTION_INDEX_SIZE]; /**< offset + 1 of the first
+                                 instance of each option number from the
+                                 start of the options, 0 if not present */
+#endif /* COAP_OPTION_INDEX */
 };
 
+#if COAP_OPTION_INDEX
+/**
+ * Drops the option index of @p pdu. Must be called whenever options are
+ * moved, inserted or removed.
+ *
+ * @param pdu The PDU.
+ */
+COAP_STATIC_INLINE void
+coap_pdu_drop_opt_index(coap_pdu_t *pdu) {
+  pdu->opt_index_size = 0;
+}
+#else /* ! COAP_OPTION_INDEX */
+#define coap_pdu_drop_opt_index(pdu)
+#endif /* ! COAP_OPTION_INDEX */
+
 /**
  * Dynamically grows the size of @p pdu to @p new_size. The new size
  * must not exceed the PDU's configure maximum size. On success, this
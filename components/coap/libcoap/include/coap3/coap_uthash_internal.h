@@ -86,7 +86,21 @@ do {
 #endif
 
 #ifndef HASH_FUNCTION
-#define HASH_FUNCTION(keyptr,keylen,hashv) HASH_JEN(keyptr, keylen, hashv)
+/**
+ * libcoap: Calculates a 32-bit hash over @p len bytes of @p key, four bytes
+ * per round (MurmurHash3 x86_32 mixing). Used as HASH_FUNCTION for the
+ * session and resource tables and by coap_hash(). Not a one-way function.
+ *
+ * @param key  The key used for hash calculation.
+ * @param len  The length of @p key.
+ * @param seed The start value, 0 for table lookups.
+ *
+ * @return The hash value.
+ */
+uint32_t coap_hash_word(const void *key, size_t len, uint32_t seed);
+
+#define HASH_FUNCTION(keyptr,keylen,hashv) \
+  (hashv) = coap_hash_word((keyptr), (keylen), 0)
 #endif
 
 #ifndef HASH_KEYCMP
@@ -0,0 +1,86 @@
+/* coap_hashkey.c -- definition of hash key type and helper functions
+ *
+ * Copyright (C) 2010,2011 Olaf Bergmann <bergmann@tzi.org>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * This file is part of the CoAP library libcoap. Please see
+ * README for terms of use.
+ */
+
+/**
+ * @file coap_hashkey.c
+ * @brief Hashkey functions
+ */
+
+#include "coap3/coap_internal.h"
+
+#define COAP_HASH_C1 0xcc9e2d51U
+#define COAP_HASH_C2 0x1b873593U
+
+static inline uint32_t
+coap_hash_rotl(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t
+coap_hash_mix(uint32_t k) {
+  k *= COAP_HASH_C1;
+  k = coap_hash_rotl(k, 15);
+  return k * COAP_HASH_C2;
+}
+
+uint32_t
+coap_hash_word(const void *key, size_t len, uint32_t seed) {
+  const uint8_t *p = (const uint8_t *)key;
+  uint32_t h = seed;
+  uint32_t k;
+  size_t n = len;
+
+  /* One 32-bit word per round, memcpy() compiles to a single load */
+  while (n >= 4) {
+    memcpy(&k, p, sizeof(k));
+    h ^= coap_hash_mix(k);
+    h = coap_hash_rotl(h, 13);
+    h = h * 5 + 0xe6546b64U;
+    p += 4;
+    n -= 4;
+  }
+
+  k = 0;
+  switch (n) {
+  case 3:
+    k ^= (uint32_t)p[2] << 16;
+  /* Fall through */
+  case 2:
+    k ^= (uint32_t)p[1] << 8;
+  /* Fall through */
+  case 1:
+    k ^= p[0];
+    h ^= coap_hash_mix(k);
+  /* Fall through */
+  default:
+    break;
+  }
+
+  /* Avalanche, so the low bits used as bucket index depend on all bytes */
+  h ^= (uint32_t)len;
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+void
+coap_hash_impl(const unsigned char *s, size_t len, coap_key_t h) {
+  uint32_t seed = (uint32_t)h[0] | (uint32_t)h[1] << 8 |
+                  (uint32_t)h[2] << 16 | (uint32_t)h[3] << 24;
+  uint32_t result = coap_hash_word(s, len, seed);
+
+  h[0] = (unsigned char)result;
+  h[1] = (unsigned char)(result >> 8);
+  h[2] = (unsigned char)(result >> 16);
+  h[3] = (unsigned char)(result >> 24);
+}
@@ -300,7 +300,10 @@ coap_socket_send_pdu(coap_socket_t *sock, coap_session_t *session,
                pdu->pbuf->payload));
 
   if (coap_debug_send_packet()) {
-    /* Need to take a copy as we may be re-using the origin in a retransmit */
+    /* Need to take a copy as we may be re-using the origin in a retransmit.
+     * A PBUF_REF to the PDU would avoid the copy, but lwIP may hold on to
+     * the pbuf (e.g. while ARP is pending) and the PDU has no reference
+     * count to keep its data alive until then. */
     pbuf = pbuf_clone(PBUF_TRANSPORT, PBUF_RAM, pdu->pbuf);
     if (pbuf == NULL)
       return -1;
@@ -157,6 +157,11 @@ typedef struct coap_mbedtls_context_t {
   char *root_ca_file;
   char *root_ca_path;
   int psk_pki_enabled;
+#if COAP_CLIENT_SUPPORT && defined(MBEDTLS_SSL_CLI_C)
+  mbedtls_ssl_session client_session; /* Last established client session,
+                                         offered for resumption */
+  int client_session_valid;
+#endif /* COAP_CLIENT_SUPPORT && MBEDTLS_SSL_CLI_C */
 } coap_mbedtls_context_t;
 
 typedef enum coap_enc_method_t {
@@ -1290,6 +1295,19 @@ do_mbedtls_handshake(coap_session_t *c_session,
     m_env->established = 1;
     coap_log_debug("*  %s: Mbed TLS established\n",
                    coap_session_str(c_session));
+#if COAP_CLIENT_SUPPORT && defined(MBEDTLS_SSL_CLI_C)
+    if (c_session->type == COAP_SESSION_TYPE_CLIENT) {
+      coap_mbedtls_context_t *m_context =
+          (coap_mbedtls_context_t *)c_session->context->dtls_context;
+
+      /* Keep the session so that the next client session can resume it */
+      mbedtls_ssl_session_free(&m_context->client_session);
+      mbedtls_ssl_session_init(&m_context->client_session);
+      m_context->client_session_valid =
+          mbedtls_ssl_get_session(&m_env->ssl,
+                                  &m_context->client_session) == 0;
+    }
+#endif /* COAP_CLIENT_SUPPORT && MBEDTLS_SSL_CLI_C */
     ret = 1;
     break;
   case MBEDTLS_ERR_SSL_WANT_READ:
@@ -1543,6 +1561,20 @@ coap_dtls_new_mbedtls_env(coap_session_t *c_session,
   if ((ret = mbedtls_ssl_setup(&m_env->ssl, &m_env->conf)) != 0) {
     goto fail;
   }
+#if COAP_CLIENT_SUPPORT && defined(MBEDTLS_SSL_CLI_C)
+  if (role == COAP_DTLS_ROLE_CLIENT) {
+    coap_mbedtls_context_t *m_context =
+        (coap_mbedtls_context_t *)c_session->context->dtls_context;
+
+    /* Offer the last session, the server falls back to a full handshake */
+    if (m_context->client_session_valid &&
+        mbedtls_ssl_set_session(&m_env->ssl,
+                                &m_context->client_session) != 0) {
+      coap_log_debug("*  %s: Mbed TLS session not resumable\n",
+                     coap_session_str(c_session));
+    }
+  }
+#endif /* COAP_CLIENT_SUPPORT && MBEDTLS_SSL_CLI_C */
   if (proto == COAP_PROTO_DTLS) {
     mbedtls_ssl_set_bio(&m_env->ssl, c_session, coap_dgram_write,
                         coap_dgram_read, NULL);
@@ -1813,6 +1845,9 @@ coap_dtls_free_context(void *dtls_context) {
     mbedtls_free(m_context->root_ca_path);
   if (m_context->root_ca_file)
     mbedtls_free(m_context->root_ca_file);
+#if COAP_CLIENT_SUPPORT && defined(MBEDTLS_SSL_CLI_C)
+  mbedtls_ssl_session_free(&m_context->client_session);
+#endif /* COAP_CLIENT_SUPPORT && MBEDTLS_SSL_CLI_C */
 
   mbedtls_free(m_context);
 }
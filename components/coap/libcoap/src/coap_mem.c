@@ -457,27 +457,320 @@ coap_realloc_type(coap_memory_tag_t type, void *p, size_t size) {
 #if defined(HAVE_MALLOC) || defined(__MINGW32__)
 #include <stdlib.h>
 
+#if COAP_MEM_POOL
+/*
+ * Fixed-size pools in static storage for the objects which are allocated
+ * and released for every message: PDUs and their buffers, sendqueue nodes,
+ * large body state and strings (tokens, OSCORE associations, Block2
+ * tracking), plus the sessions, and optionally bodies up to
+ * COAP_MEM_POOL_BODY_BUF_SIZE (the request copy of a client, the
+ * reassembled request of a server). A free list per pool makes allocation
+ * O(1) without heap fragmentation. Requests which do not fit a pool (too
+ * large or pool empty) fall back to malloc() and are counted as failures
+ * of the pool.
+ */
+
+#ifndef COAP_MEM_POOL_PDUS
+#define COAP_MEM_POOL_PDUS           (32U)
+#endif /* COAP_MEM_POOL_PDUS */
+
+#ifndef COAP_MEM_POOL_SMALL_BUFS
+#define COAP_MEM_POOL_SMALL_BUFS     (32U)
+#endif /* COAP_MEM_POOL_SMALL_BUFS */
+
+#ifndef COAP_MEM_POOL_LARGE_BUFS
+#define COAP_MEM_POOL_LARGE_BUFS     (16U)
+#endif /* COAP_MEM_POOL_LARGE_BUFS */
+
+#ifndef COAP_MEM_POOL_BODY_BUFS
+#define COAP_MEM_POOL_BODY_BUFS      (0U)
+#endif /* COAP_MEM_POOL_BODY_BUFS */
+
+#ifndef COAP_MEM_POOL_BODY_BUF_SIZE
+#define COAP_MEM_POOL_BODY_BUF_SIZE  (10240U)
+#endif /* COAP_MEM_POOL_BODY_BUF_SIZE */
+
+#ifndef COAP_MEM_POOL_NODES
+#define COAP_MEM_POOL_NODES          (32U)
+#endif /* COAP_MEM_POOL_NODES */
+
+#ifndef COAP_MEM_POOL_SESSIONS
+#define COAP_MEM_POOL_SESSIONS       (4U)
+#endif /* COAP_MEM_POOL_SESSIONS */
+
+#ifndef COAP_MEM_POOL_LARGE_BODIES
+#define COAP_MEM_POOL_LARGE_BODIES   (8U)
+#endif /* COAP_MEM_POOL_LARGE_BODIES */
+
+#ifndef COAP_MEM_POOL_STRINGS
+#define COAP_MEM_POOL_STRINGS        (32U)
+#endif /* COAP_MEM_POOL_STRINGS */
+
+#ifndef COAP_MEM_POOL_LARGE_STRINGS
+#define COAP_MEM_POOL_LARGE_STRINGS  (16U)
+#endif /* COAP_MEM_POOL_LARGE_STRINGS */
+
+/*
+ * Initial PDU buffer (coap_pdu_init()) and a full MTU PDU with header, also
+ * the OSCORE ciphertext of a PDU
+ */
+#define COAP_MEM_POOL_SMALL_BUF_SIZE (256U + COAP_PDU_MAX_TCP_HEADER_SIZE)
+#define COAP_MEM_POOL_LARGE_BUF_SIZE (COAP_DEFAULT_MTU + COAP_PDU_MAX_TCP_HEADER_SIZE)
+#define COAP_MEM_POOL_STRING_SIZE    (64U)
+/* OSCORE association, Block2 send tracking, DTLS and OSCORE setup */
+#define COAP_MEM_POOL_LARGE_STRING_SIZE (256U)
+
+#if defined(ESPIDF_VERSION)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+#define POOL_LOCK()   taskENTER_CRITICAL(&pool_lock)
+#define POOL_UNLOCK() taskEXIT_CRITICAL(&pool_lock)
+#elif defined(HAVE_PTHREAD_H) && defined(HAVE_PTHREAD_MUTEX_LOCK)
+#include <pthread.h>
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#define POOL_LOCK()   pthread_mutex_lock(&pool_lock)
+#define POOL_UNLOCK() pthread_mutex_unlock(&pool_lock)
+#else /* ! ESPIDF_VERSION && ! HAVE_PTHREAD_MUTEX_LOCK */
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#endif /* ! ESPIDF_VERSION && ! HAVE_PTHREAD_MUTEX_LOCK */
+
+/* Storage of one block, the free list is kept in the unused blocks */
+#define POOL_STORAGE(Name, Size, Count)        \
+  static union {                               \
+    void *next;                                \
+    uint64_t align;                            \
+    uint8_t data[(Size)];                      \
+  } Name ## _pool_data[(Count)]
+
+POOL_STORAGE(pdu, sizeof(coap_pdu_t), COAP_MEM_POOL_PDUS);
+POOL_STORAGE(small_buf, COAP_MEM_POOL_SMALL_BUF_SIZE, COAP_MEM_POOL_SMALL_BUFS);
+POOL_STORAGE(large_buf, COAP_MEM_POOL_LARGE_BUF_SIZE, COAP_MEM_POOL_LARGE_BUFS);
+POOL_STORAGE(node, sizeof(coap_queue_t), COAP_MEM_POOL_NODES);
+POOL_STORAGE(session, sizeof(coap_session_t), COAP_MEM_POOL_SESSIONS);
+POOL_STORAGE(lg_xmit, sizeof(coap_lg_xmit_t), COAP_MEM_POOL_LARGE_BODIES);
+#if COAP_CLIENT_SUPPORT
+POOL_STORAGE(lg_crcv, sizeof(coap_lg_crcv_t), COAP_MEM_POOL_LARGE_BODIES);
+#endif /* COAP_CLIENT_SUPPORT */
+#if COAP_SERVER_SUPPORT
+POOL_STORAGE(lg_srcv, sizeof(coap_lg_srcv_t), COAP_MEM_POOL_LARGE_BODIES);
+#endif /* COAP_SERVER_SUPPORT */
+POOL_STORAGE(string, COAP_MEM_POOL_STRING_SIZE, COAP_MEM_POOL_STRINGS);
+POOL_STORAGE(large_string, COAP_MEM_POOL_LARGE_STRING_SIZE, COAP_MEM_POOL_LARGE_STRINGS);
+#if COAP_MEM_POOL_BODY_BUFS > 0
+/*
+ * A client keeps a copy of every request body (coap_block_new_lg_crcv()),
+ * a server reassembles a Block1 body into a string (coap_block_build_body())
+ */
+POOL_STORAGE(body_buf, COAP_MEM_POOL_BODY_BUF_SIZE, COAP_MEM_POOL_BODY_BUFS);
+#endif /* COAP_MEM_POOL_BODY_BUFS > 0 */
+
+/* Types a pool serves, one bit per coap_memory_tag_t */
+#define POOL_TYPE(Type) (1UL << (Type))
+
+typedef struct coap_mem_pool_t {
+  const char *name;
+  unsigned long types;
+  size_t block_size;
+  unsigned int blocks;
+  uint8_t *start;
+  uint8_t *end;
+  void *free_list;
+  unsigned int used;
+  unsigned int high_water;
+  unsigned int failures;
+} coap_mem_pool_t;
+
+#define POOL_ENTRY(Name, Types) \
+  { #Name, (Types), sizeof(Name ## _pool_data[0]), \
+    sizeof(Name ## _pool_data) / sizeof(Name ## _pool_data[0]), \
+    (uint8_t *)Name ## _pool_data, \
+    (uint8_t *)Name ## _pool_data + sizeof(Name ## _pool_data), NULL, 0, 0, 0 }
+
+/* Pools of the same type in ascending block size */
+static coap_mem_pool_t pools[] = {
+  POOL_ENTRY(pdu, POOL_TYPE(COAP_PDU)),
+  POOL_ENTRY(small_buf, POOL_TYPE(COAP_PDU_BUF) | POOL_TYPE(COAP_OSCORE_BUF)),
+  POOL_ENTRY(large_buf, POOL_TYPE(COAP_PDU_BUF) | POOL_TYPE(COAP_OSCORE_BUF)),
+  POOL_ENTRY(node, POOL_TYPE(COAP_NODE)),
+  POOL_ENTRY(session, POOL_TYPE(COAP_SESSION)),
+  POOL_ENTRY(lg_xmit, POOL_TYPE(COAP_LG_XMIT)),
+#if COAP_CLIENT_SUPPORT
+  POOL_ENTRY(lg_crcv, POOL_TYPE(COAP_LG_CRCV)),
+#endif /* COAP_CLIENT_SUPPORT */
+#if COAP_SERVER_SUPPORT
+  POOL_ENTRY(lg_srcv, POOL_TYPE(COAP_LG_SRCV)),
+#endif /* COAP_SERVER_SUPPORT */
+  POOL_ENTRY(string, POOL_TYPE(COAP_STRING)),
+  POOL_ENTRY(large_string, POOL_TYPE(COAP_STRING)),
+#if COAP_MEM_POOL_BODY_BUFS > 0
+  POOL_ENTRY(body_buf, POOL_TYPE(COAP_PDU_BUF) | POOL_TYPE(COAP_OSCORE_BUF) |
+             POOL_TYPE(COAP_STRING)),
+#endif /* COAP_MEM_POOL_BODY_BUFS > 0 */
+};
+
+#define POOL_COUNT (sizeof(pools) / sizeof(pools[0]))
+
+static int pools_ready = 0;
+
+/* Called with POOL_LOCK() held */
+static void
+coap_mem_pool_init(void) {
+  for (size_t i = 0; i < POOL_COUNT; i++) {
+    coap_mem_pool_t *pool = &pools[i];
+
+    pool->free_list = NULL;
+    for (unsigned int j = pool->blocks; j-- > 0;) {
+      void **block = (void **)(pool->start + j * pool->block_size);
+
+      *block = pool->free_list;
+      pool->free_list = block;
+    }
+  }
+  pools_ready = 1;
+}
+
+/*
+ * Pool which owns p, NULL if p is from the heap. Only the address decides:
+ * a block freed with another type than it was allocated with (e.g. a
+ * COAP_STRING freed as COAP_PDU_BUF) must go back to its pool, not to free().
+ */
+static coap_mem_pool_t *
+coap_mem_pool_find(const void *p) {
+  for (size_t i = 0; i < POOL_COUNT; i++) {
+    if ((const uint8_t *)p >= pools[i].start &&
+        (const uint8_t *)p < pools[i].end)
+      return &pools[i];
+  }
+  return NULL;
+}
+
 void
 coap_memory_init(void) {
+  POOL_LOCK();
+  if (!pools_ready)
+    coap_mem_pool_init();
+  POOL_UNLOCK();
 }
 
 void *
 coap_malloc_type(coap_memory_tag_t type, size_t size) {
+  coap_mem_pool_t *fit = NULL;
+  void **block = NULL;
+
+  POOL_LOCK();
+  if (!pools_ready)
+    coap_mem_pool_init();
+  for (size_t i = 0; i < POOL_COUNT; i++) {
+    coap_mem_pool_t *pool = &pools[i];
+
+    if (!(pool->types & POOL_TYPE(type)))
+      continue;
+    /* A failure is counted for the largest pool of the type */
+    fit = pool;
+    if (size > pool->block_size)
+      continue;
+    if (pool->free_list) {
+      block = pool->free_list;
+      pool->free_list = *block;
+      if (++pool->used > pool->high_water)
+        pool->high_water = pool->used;
+      break;
+    }
+  }
+  if (fit && !block)
+    fit->failures++;
+  POOL_UNLOCK();
+
+  return block ? (void *)block : malloc(size);
+}
+
+void *
+coap_realloc_type(coap_memory_tag_t type, void *p, size_t size) {
+  coap_mem_pool_t *pool;
+  void *q;
+
+  if (!p)
+    return coap_malloc_type(type, size);
+  if (size == 0) {
+    coap_free_type(type, p);
+    return NULL;
+  }
+  pool = coap_mem_pool_find(p);
+  if (!pool)
+    return realloc(p, size);
+  if (size <= pool->block_size)
+    return p;
+  /* Move into the next larger pool (or the heap) */
+  q = coap_malloc_type(type, size);
+  if (q) {
+    memcpy(q, p, pool->block_size);
+    coap_free_type(type, p);
+  }
+  return q;
+}
+
+void
+coap_free_type(coap_memory_tag_t type, void *p) {
+  coap_mem_pool_t *pool;
+
   (void)type;
+
+  if (!p)
+    return;
+  pool = coap_mem_pool_find(p);
+  if (!pool) {
+    free(p);
+    return;
+  }
+  POOL_LOCK();
+  *(void **)p = pool->free_list;
+  pool->free_list = p;
+  pool->used--;
+  POOL_UNLOCK();
+}
+
+unsigned int
+coap_mem_pool_stats(coap_mem_pool_stats_t *stats, unsigned int count) {
+  unsigned int i;
+
+  POOL_LOCK();
+  for (i = 0; i < count && i < POOL_COUNT; i++) {
+    stats[i].name = pools[i].name;
+    stats[i].block_size = pools[i].block_size;
+    stats[i].blocks = pools[i].blocks;
+    stats[i].used = pools[i].used;
+    stats[i].high_water = pools[i].high_water;
+    stats[i].failures = pools[i].failures;
+  }
+  POOL_UNLOCK();
+  return i;
+}
+
+#else /* ! COAP_MEM_POOL */
+
+void
+coap_memory_init(void) {
+}
+
+void *
+coap_malloc_type(coap_memory_tag_t type, size_t size) {
   return malloc(size);
 }
 
 void *
 coap_realloc_type(coap_memory_tag_t type, void *p, size_t size) {
-  (void)type;
   return realloc(p, size);
 }
 
 void
 coap_free_type(coap_memory_tag_t type, void *p) {
-  (void)type;
   free(p);
 }
+#endif /* ! COAP_MEM_POOL */
 
 #else /* ! HAVE_MALLOC  && !__MINGW32__ */
 
@@ -507,3 +800,12 @@ coap_free_type(coap_memory_tag_t type, void *ptr) {
 #endif /* ! HAVE_MALLOC */
 
 #endif /* ! RIOT_VERSION */
+
+#if !COAP_MEM_POOL || !(defined(HAVE_MALLOC) || defined(__MINGW32__)) || defined(RIOT_VERSION)
+unsigned int
+coap_mem_pool_stats(coap_mem_pool_stats_t *stats, unsigned int count) {
+  (void)stats;
+  (void)count;
+  return 0;
+}
+#endif /* ! COAP_MEM_POOL */
@@ -125,11 +125,153 @@ coap_free_node(coap_queue_t *node) {
 }
 #endif /* WITH_LWIP */
 
+#if COAP_SENDQUEUE_HEAP
+/*
+ * The sendqueue as binary min-heap: insert and remove are O(log n) instead
+ * of the O(n) walk through the delta list, which matters with many CON and
+ * Q-Block messages in flight. Every node->t is relative to
+ * sendqueue_basetime, context->sendqueue is always the earliest node.
+ */
+
+static void
+coap_sendqueue_set(coap_context_t *context, size_t i, coap_queue_t *node) {
+  context->sendqueue_heap[i] = node;
+  node->heap_index = i + 1;
+}
+
+static void
+coap_sendqueue_sift_up(coap_context_t *context, size_t i) {
+  coap_queue_t *node = context->sendqueue_heap[i];
+
+  while (i > 0 && node->t < context->sendqueue_heap[(i - 1) / 2]->t) {
+    coap_sendqueue_set(context, i, context->sendqueue_heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
+  }
+  coap_sendqueue_set(context, i, node);
+}
+
+static void
+coap_sendqueue_sift_down(coap_context_t *context, size_t i) {
+  coap_queue_t *node = context->sendqueue_heap[i];
+  size_t child;
+
+  while ((child = 2 * i + 1) < context->sendqueue_count) {
+    if (child + 1 < context->sendqueue_count &&
+        context->sendqueue_heap[child + 1]->t < context->sendqueue_heap[child]->t)
+      child++;
+    if (node->t <= context->sendqueue_heap[child]->t)
+      break;
+    coap_sendqueue_set(context, i, context->sendqueue_heap[child]);
+    i = child;
+  }
+  coap_sendqueue_set(context, i, node);
+}
+
+static void
+coap_sendqueue_free_heap(coap_context_t *context) {
+#if COAP_MEM_POOL
+  if (context->sendqueue_heap == context->sendqueue_fixed)
+    return;
+#endif /* COAP_MEM_POOL */
+  coap_free_type(COAP_STRING, context->sendqueue_heap);
+}
+
+static int
+coap_sendqueue_push(coap_context_t *context, coap_queue_t *node) {
+#if COAP_MEM_POOL
+  if (context->sendqueue_size == 0) {
+    context->sendqueue_heap = context->sendqueue_fixed;
+    context->sendqueue_size = COAP_SENDQUEUE_HEAP_FIXED;
+  }
+#endif /* COAP_MEM_POOL */
+  if (context->sendqueue_count == context->sendqueue_size) {
+    size_t size = context->sendqueue_size ? 2 * context->sendqueue_size : 16;
+    coap_queue_t **heap = coap_malloc_type(COAP_STRING, size * sizeof(coap_queue_t *));
+
+    if (!heap)
+      return 0;
+    if (context->sendqueue_heap) {
+      memcpy(heap, context->sendqueue_heap,
+             context->sendqueue_count * sizeof(coap_queue_t *));
+      coap_sendqueue_free_heap(context);
+    }
+    context->sendqueue_heap = heap;
+    context->sendqueue_size = size;
+  }
+  node->next = NULL;
+  context->sendqueue_heap[context->sendqueue_count++] = node;
+  coap_sendqueue_sift_up(context, context->sendqueue_count - 1);
+  context->sendqueue = context->sendqueue_heap[0];
+  return 1;
+}
+
+static coap_queue_t *
+coap_sendqueue_remove_at(coap_context_t *context, size_t i) {
+  coap_queue_t *node = context->sendqueue_heap[i];
+  coap_queue_t *last = context->sendqueue_heap[--context->sendqueue_count];
+
+  if (i < context->sendqueue_count) {
+    coap_sendqueue_set(context, i, last);
+    coap_sendqueue_sift_down(context, i);
+    coap_sendqueue_sift_up(context, last->heap_index - 1);
+  }
+  context->sendqueue = context->sendqueue_count ? context->sendqueue_heap[0] : NULL;
+  node->heap_index = 0;
+  node->next = NULL;
+  return node;
+}
+
+/*
+ * Removes all nodes of session (and token, if given) in one pass and
+ * rebuilds the heap. Returns the removed nodes linked through next.
+ */
+static coap_queue_t *
+coap_sendqueue_extract(coap_context_t *context, coap_session_t *session,
+                       coap_bin_const_t *token) {
+  coap_queue_t *removed = NULL;
+  coap_queue_t *node;
+  size_t kept = 0;
+  size_t i;
+
+  for (i = 0; i < context->sendqueue_count; i++) {
+    node = context->sendqueue_heap[i];
+    if (node->session == session &&
+        (!token || coap_binary_equal(&node->pdu->actual_token, token))) {
+      node->heap_index = 0;
+      node->next = removed;
+      removed = node;
+    } else {
+      coap_sendqueue_set(context, kept++, node);
+    }
+  }
+  context->sendqueue_count = kept;
+  for (i = kept / 2; i-- > 0;)
+    coap_sendqueue_sift_down(context, i);
+  context->sendqueue = kept ? context->sendqueue_heap[0] : NULL;
+  return removed;
+}
+#endif /* COAP_SENDQUEUE_HEAP */
+
 unsigned int
 coap_adjust_basetime(coap_context_t *ctx, coap_tick_t now) {
   unsigned int result = 0;
   coap_tick_diff_t delta = now - ctx->sendqueue_basetime;
 
+#if COAP_SENDQUEUE_HEAP
+  /* Same shift for every node keeps the heap order */
+  for (size_t i = 0; i < ctx->sendqueue_count; i++) {
+    coap_queue_t *q = ctx->sendqueue_heap[i];
+
+    if (delta <= 0) {
+      q->t -= delta;
+    } else if (q->t < (coap_tick_t)delta) {
+      q->t = 0;
+      result++;
+    } else {
+      q->t -= delta;
+    }
+  }
+#else /* ! COAP_SENDQUEUE_HEAP */
   if (ctx->sendqueue) {
     /* delta < 0 means that the new time stamp is before the old. */
     if (delta <= 0) {
@@ -155,6 +297,7 @@ coap_adjust_basetime(coap_context_t *ctx, coap_tick_t now) {
       }
     }
   }
+#endif /* ! COAP_SENDQUEUE_HEAP */
 
   /* adjust basetime */
   ctx->sendqueue_basetime += delta;
@@ -168,6 +311,11 @@ coap_insert_node(coap_queue_t **queue, coap_queue_t *node) {
   if (!queue || !node)
     return 0;
 
+#if COAP_SENDQUEUE_HEAP
+  if (node->session && queue == &node->session->context->sendqueue)
+    return coap_sendqueue_push(node->session->context, node);
+#endif /* COAP_SENDQUEUE_HEAP */
+
   /* set queue head if empty */
   if (!*queue) {
     *queue = node;
@@ -209,9 +357,15 @@ coap_delete_node(coap_queue_t *node) {
     /*
      * Need to remove out of context->sendqueue as added in by coap_wait_ack()
      */
+#if COAP_SENDQUEUE_HEAP
+    if (node->heap_index) {
+      coap_sendqueue_remove_at(node->session->context, node->heap_index - 1);
+    }
+#else /* ! COAP_SENDQUEUE_HEAP */
     if (node->session->context->sendqueue) {
       LL_DELETE(node->session->context->sendqueue, node);
     }
+#endif /* ! COAP_SENDQUEUE_HEAP */
     coap_session_release(node->session);
   }
   coap_free_node(node);
@@ -242,6 +396,30 @@ coap_new_node(void) {
   return node;
 }
 
+coap_queue_t *
+coap_find_session_node(coap_context_t *context, coap_session_t *session) {
+#if COAP_SENDQUEUE_HEAP
+  coap_queue_t *first = NULL;
+
+  /* Heap order is not sorted, like the list the earliest node is returned */
+  for (size_t i = 0; i < context->sendqueue_count; i++) {
+    coap_queue_t *q = context->sendqueue_heap[i];
+
+    if (q->session == session && (!first || q->t < first->t))
+      first = q;
+  }
+  return first;
+#else /* ! COAP_SENDQUEUE_HEAP */
+  coap_queue_t *q;
+
+  LL_FOREACH(context->sendqueue, q) {
+    if (q->session == session)
+      return q;
+  }
+  return NULL;
+#endif /* ! COAP_SENDQUEUE_HEAP */
+}
+
 coap_queue_t *
 coap_peek_next(coap_context_t *context) {
   if (!context || !context->sendqueue)
@@ -257,6 +435,9 @@ coap_pop_next(coap_context_t *context) {
   if (!context || !context->sendqueue)
     return NULL;
 
+#if COAP_SENDQUEUE_HEAP
+  return coap_sendqueue_remove_at(context, 0);
+#endif /* COAP_SENDQUEUE_HEAP */
   next = context->sendqueue;
   context->sendqueue = context->sendqueue->next;
   if (context->sendqueue) {
@@ -572,7 +753,15 @@ coap_free_context(coap_context_t *context) {
   coap_delete_all_resources(context);
 #endif /* COAP_SERVER_SUPPORT */
 
+#if COAP_SENDQUEUE_HEAP
+  while (context->sendqueue)
+    coap_delete_node(context->sendqueue);
+  coap_sendqueue_free_heap(context);
+  context->sendqueue_heap = NULL;
+  context->sendqueue_size = 0;
+#else /* ! COAP_SENDQUEUE_HEAP */
   coap_delete_all(context->sendqueue);
+#endif /* ! COAP_SENDQUEUE_HEAP */
 
 #ifdef WITH_LWIP
   context->sendqueue = NULL;
@@ -928,7 +1117,15 @@ coap_wait_ack(coap_context_t *context, coap_session_t *session,
               (node->timeout << node->retransmit_cnt);
   }
 
-  coap_insert_node(&context->sendqueue, node);
+  if (!coap_insert_node(&context->sendqueue, node)) {
+    /* Only the heap can fail to grow, the message is not tracked anymore */
+    coap_log_warn("** %s: mid=0x%04x: retransmit queue full, dropped\n",
+                  coap_session_str(node->session), node->id);
+    if (node->pdu->type == COAP_MESSAGE_CON && session->con_active)
+      session->con_active--;
+    coap_delete_node(node);
+    return COAP_INVALID_MID;
+  }
 
   coap_log_debug("** %s: mid=0x%04x: added to retransmit queue (%ums)\n",
                  coap_session_str(node->session), node->id,
@@ -1638,6 +1835,7 @@ coap_retransmit(coap_context_t *context, coap_queue_t *node) {
       /* make node->t relative to context->sendqueue_basetime */
       node->t = (now - context->sendqueue_basetime) + next_delay;
     }
+    /* node was popped before, so the heap has room and this can not fail */
     coap_insert_node(&context->sendqueue, node);
 
     if (node->is_mcast) {
@@ -2241,6 +2439,23 @@ coap_remove_from_queue(coap_queue_t **queue, coap_session_t *session, coap_mid_t
   if (!queue || !*queue)
     return 0;
 
+#if COAP_SENDQUEUE_HEAP
+  if (queue == &session->context->sendqueue) {
+    coap_context_t *context = session->context;
+
+    for (size_t i = 0; i < context->sendqueue_count; i++) {
+      if (session == context->sendqueue_heap[i]->session &&
+          id == context->sendqueue_heap[i]->id) {
+        *node = coap_sendqueue_remove_at(context, i);
+        coap_log_debug("** %s: mid=0x%04x: removed (1)\n",
+                       coap_session_str(session), id);
+        return 1;
+      }
+    }
+    return 0;
+  }
+#endif /* COAP_SENDQUEUE_HEAP */
+
   /* replace queue head if PDU's time is less than head's time */
 
   if (session == (*queue)->session && id == (*queue)->id) { /* found message id */
@@ -2283,6 +2498,23 @@ coap_cancel_session_messages(coap_context_t *context, coap_session_t *session,
                              coap_nack_reason_t reason) {
   coap_queue_t *p, *q;
 
+#if COAP_SENDQUEUE_HEAP
+  p = coap_sendqueue_extract(context, session, NULL);
+  while (p) {
+    q = p;
+    p = p->next;
+    q->next = NULL;
+    coap_log_debug("** %s: mid=0x%04x: removed (3)\n",
+                   coap_session_str(session), q->id);
+    if (q->pdu->type == COAP_MESSAGE_CON && context->nack_handler) {
+      coap_check_update_token(session, q->pdu);
+      context->nack_handler(session, q->pdu, reason, q->id);
+    }
+    coap_delete_node(q);
+  }
+  return;
+#endif /* COAP_SENDQUEUE_HEAP */
+
   while (context->sendqueue && context->sendqueue->session == session) {
     q = context->sendqueue;
     context->sendqueue = q->next;
@@ -2329,6 +2561,28 @@ coap_cancel_all_messages(coap_context_t *context, coap_session_t *session,
   if (!context->sendqueue)
     return;
 
+#if COAP_SENDQUEUE_HEAP
+  {
+    coap_queue_t *removed = coap_sendqueue_extract(context, session, token);
+
+    while (removed) {
+      q = removed;
+      removed = removed->next;
+      q->next = NULL;
+      coap_log_debug("** %s: mid=0x%04x: removed (6)\n",
+                     coap_session_str(session), q->id);
+      if (q->pdu->type == COAP_MESSAGE_CON && session->con_active) {
+        session->con_active--;
+        if (session->state == COAP_SESSION_STATE_ESTABLISHED)
+          /* Flush out any entries on session->delayqueue */
+          coap_session_connected(session);
+      }
+      coap_delete_node(q);
+    }
+    return;
+  }
+#endif /* COAP_SENDQUEUE_HEAP */
+
   p = &context->sendqueue;
   q = *p;
 
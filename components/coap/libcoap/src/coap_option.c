@@ -199,12 +199,44 @@ coap_opt_t *
 coap_check_option(const coap_pdu_t *pdu, coap_option_num_t number,
                   coap_opt_iterator_t *oi) {
   coap_opt_filter_t f;
+#if COAP_OPTION_INDEX
+  int indexed = pdu->opt_index_size && pdu->opt_index_size == pdu->used_size;
+
+  if (indexed && (number > pdu->max_opt ||
+                  (number < COAP_OPTION_INDEX_SIZE &&
+                   pdu->opt_index[number] == 0))) {
+    /* Not in the PDU, no need to walk the options */
+    memset(oi, 0, sizeof(coap_opt_iterator_t));
+    oi->bad = 1;
+    return NULL;
+  }
+#endif /* COAP_OPTION_INDEX */
 
   coap_option_filter_clear(&f);
   coap_option_filter_set(&f, number);
 
   coap_option_iterator_init(pdu, oi, &f);
 
+#if COAP_OPTION_INDEX
+  if (indexed && number < COAP_OPTION_INDEX_SIZE && !oi->bad) {
+    /*
+     * Continue the iterator just before the first instance, so that
+     * coap_option_next() delivers it and any repeated instances.
+     */
+    size_t offset = pdu->opt_index[number] - 1;
+    coap_option_t option;
+
+    if (!coap_opt_parse(oi->next_option + offset, oi->length - offset,
+                        &option)) {
+      oi->bad = 1;
+      return NULL;
+    }
+    oi->next_option += offset;
+    oi->length -= offset;
+    oi->number = number - option.delta;
+  }
+#endif /* COAP_OPTION_INDEX */
+
   return coap_option_next(oi);
 }
 
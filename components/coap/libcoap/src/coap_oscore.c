@@ -586,8 +586,9 @@ coap_oscore_new_pdu_encrypted(coap_session_t *session,
   cose_encrypt0_set_key(cose, snd_ctx->sender_key);
   cose_encrypt0_set_plaintext(cose, plain_pdu->token, plain_pdu->used_size);
   dump_cose(cose, "Pre encrypt");
+  /* Only the ciphertext and tag, COAP_MAX_CHUNK_SIZE can be megabytes */
   ciphertext_buffer =
-      coap_malloc_type(COAP_OSCORE_BUF, OSCORE_CRYPTO_BUFFER_SIZE);
+      coap_malloc_type(COAP_OSCORE_BUF, plain_pdu->used_size + AES_CCM_TAG);
   if (ciphertext_buffer == NULL)
     goto error;
   ciphertext_len = cose_encrypt0_encrypt(cose,
@@ -62,6 +62,7 @@ coap_pdu_clear(coap_pdu_t *pdu, size_t size) {
   pdu->body_total = 0;
   pdu->lg_xmit = NULL;
   pdu->session = NULL;
+  coap_pdu_drop_opt_index(pdu);
 }
 
 #ifdef WITH_LWIP
@@ -93,9 +94,13 @@ coap_pdu_from_pbuf(struct pbuf *pbuf) {
 }
 #endif /* LWIP */
 
-coap_pdu_t *
-coap_pdu_init(coap_pdu_type_t type, coap_pdu_code_t code, coap_mid_t mid,
-              size_t size) {
+/*
+ * Allocates a PDU of up to size bytes with an initial buffer of alloc_size
+ * bytes (ignored with lwIP, the pbuf always holds size bytes).
+ */
+static coap_pdu_t *
+coap_pdu_alloc(coap_pdu_type_t type, coap_pdu_code_t code, coap_mid_t mid,
+               size_t size, size_t alloc_size) {
   coap_pdu_t *pdu;
 
   assert(type <= 0x3);
@@ -134,7 +139,7 @@ coap_pdu_init(coap_pdu_type_t type, coap_pdu_code_t code, coap_mid_t mid,
   pdu->token = (uint8_t *)pdu->pbuf->payload + pdu->max_hdr_size;
 #else /* WITH_LWIP */
   uint8_t *buf;
-  pdu->alloc_size = min(size, 256);
+  pdu->alloc_size = alloc_size;
   buf = coap_malloc_type(COAP_PDU_BUF, pdu->alloc_size + pdu->max_hdr_size);
   if (buf == NULL) {
     coap_free_type(COAP_PDU, pdu);
@@ -149,6 +154,12 @@ coap_pdu_init(coap_pdu_type_t type, coap_pdu_code_t code, coap_mid_t mid,
   return pdu;
 }
 
+coap_pdu_t *
+coap_pdu_init(coap_pdu_type_t type, coap_pdu_code_t code, coap_mid_t mid,
+              size_t size) {
+  return coap_pdu_alloc(type, code, mid, size, min(size, 256));
+}
+
 coap_pdu_t *
 coap_new_pdu(coap_pdu_type_t type, coap_pdu_code_t code,
              coap_session_t *session) {
@@ -352,6 +363,7 @@ coap_add_token(coap_pdu_t *pdu, size_t len, const uint8_t *data) {
   pdu->max_opt = 0;
   pdu->used_size = len + bias;
   pdu->data = NULL;
+  coap_pdu_drop_opt_index(pdu);
 
   return 1;
 }
@@ -396,6 +408,11 @@ coap_update_token(coap_pdu_t *pdu, size_t len, const uint8_t *data) {
   if (pdu->data) {
     pdu->data += (len + bias) - pdu->e_token_length;
   }
+#if COAP_OPTION_INDEX
+  /* The options only moved as a whole, the index is relative to them */
+  if (pdu->opt_index_size)
+    pdu->opt_index_size += (len + bias) - pdu->e_token_length;
+#endif /* COAP_OPTION_INDEX */
 
   pdu->actual_token.length = len;
   pdu->actual_token.s = &pdu->token[bias];
@@ -431,6 +448,7 @@ coap_remove_option(coap_pdu_t *pdu, coap_option_num_t number) {
   coap_option_t decode_this;
   coap_option_t decode_next;
 
+  coap_pdu_drop_opt_index(pdu);
   /* Need to locate where in current options to remove this one */
   coap_option_iterator_init(pdu, &opt_iter, COAP_OPT_ALL);
   while ((option = coap_option_next(&opt_iter))) {
@@ -573,6 +591,7 @@ coap_insert_option(coap_pdu_t *pdu, coap_option_num_t number, size_t len,
   if (number >= pdu->max_opt)
     return coap_add_option_internal(pdu, number, len, data);
 
+  coap_pdu_drop_opt_index(pdu);
   /* Need to locate where in current options to insert this one */
   coap_option_iterator_init(pdu, &opt_iter, COAP_OPT_ALL);
   while ((option = coap_option_next(&opt_iter))) {
@@ -673,9 +692,11 @@ coap_update_option(coap_pdu_t *pdu, coap_option_num_t number, size_t len,
     option = coap_check_option(pdu, number, &opt_iter);
   }
 
-  if (new_length != old_length)
+  if (new_length != old_length) {
+    coap_pdu_drop_opt_index(pdu);
     memmove(&option[new_length], &option[old_length],
             pdu->used_size - (option - pdu->token) - old_length);
+  }
 
   if (!coap_opt_encode(option, new_length,
                        decode.delta, data, len))
@@ -735,6 +756,7 @@ coap_add_option_internal(coap_pdu_t *pdu, coap_option_num_t number, size_t len,
   if (!coap_pdu_check_resize(pdu,
                              pdu->used_size + optsize))
     return 0;
+  coap_pdu_drop_opt_index(pdu);
 
   if (pdu->data) {
     /* include option delimiter */
@@ -793,6 +815,166 @@ coap_add_data_after(coap_pdu_t *pdu, size_t len) {
   return pdu->data;
 }
 
+void
+coap_pdu_builder_init(coap_pdu_builder_t *builder, coap_pdu_type_t type,
+                      coap_pdu_code_t code) {
+  assert(builder);
+  builder->type = type;
+  builder->code = code;
+  builder->token = NULL;
+  builder->token_length = 0;
+  builder->data = NULL;
+  builder->data_length = 0;
+  builder->option_count = 0;
+  builder->failed = 0;
+}
+
+int
+coap_pdu_builder_add_token(coap_pdu_builder_t *builder, size_t len,
+                           const uint8_t *data) {
+  assert(builder);
+  if (len > COAP_TOKEN_EXT_MAX) {
+    coap_log_warn("coap_pdu_builder_add_token: Token size too large\n");
+    builder->failed = 1;
+    return 0;
+  }
+  builder->token = data;
+  builder->token_length = len;
+  return 1;
+}
+
+int
+coap_pdu_builder_add_option(coap_pdu_builder_t *builder,
+                            coap_option_num_t number, size_t len,
+                            const uint8_t *data) {
+  assert(builder);
+  if (builder->option_count == COAP_PDU_BUILDER_MAX_OPTIONS) {
+    coap_log_warn("coap_pdu_builder_add_option: too many options\n");
+    builder->failed = 1;
+    return 0;
+  }
+  builder->options[builder->option_count].number = number;
+  builder->options[builder->option_count].length = len;
+  builder->options[builder->option_count].value = data;
+  builder->option_count++;
+  return 1;
+}
+
+void
+coap_pdu_builder_add_data(coap_pdu_builder_t *builder, size_t len,
+                          const uint8_t *data) {
+  assert(builder);
+  builder->data = data;
+  builder->data_length = len;
+}
+
+coap_pdu_t *
+coap_pdu_builder_build(coap_pdu_builder_t *builder, coap_mid_t mid,
+                       size_t max_size, uint8_t **payload) {
+  /* Hop-Limit to insert for a proxy request, as coap_add_option() does */
+  static const uint8_t hop_limit = COAP_OPTION_HOP_LIMIT;
+  coap_pdu_t *pdu;
+  coap_opt_t *opt;
+  size_t size;
+  size_t i;
+  size_t j;
+  int proxy = 0;
+  int hop = 0;
+  uint16_t prev = 0;
+
+  assert(builder);
+  if (payload)
+    *payload = NULL;
+  if (builder->failed)
+    return NULL;
+
+  if (builder->code != 0 && builder->code < 32) {
+    for (i = 0; i < builder->option_count; i++) {
+      if (builder->options[i].number == COAP_OPTION_PROXY_URI ||
+          builder->options[i].number == COAP_OPTION_PROXY_SCHEME)
+        proxy = 1;
+      else if (builder->options[i].number == COAP_OPTION_HOP_LIMIT)
+        hop = 1;
+    }
+    if (proxy && !hop &&
+        !coap_pdu_builder_add_option(builder, COAP_OPTION_HOP_LIMIT, 1,
+                                     &hop_limit))
+      return NULL;
+  }
+
+  /* Stable insertion sort, repeated options keep their order */
+  for (i = 1; i < builder->option_count; i++) {
+    coap_option_num_t number = builder->options[i].number;
+    size_t length = builder->options[i].length;
+    const uint8_t *value = builder->options[i].value;
+
+    for (j = i; j > 0 && builder->options[j - 1].number > number; j--)
+      builder->options[j] = builder->options[j - 1];
+    builder->options[j].number = number;
+    builder->options[j].length = length;
+    builder->options[j].value = value;
+  }
+
+  /* Exact size of token, options and payload */
+  size = builder->token_length;
+  if (builder->token_length >= COAP_TOKEN_EXT_2B_BIAS)
+    size += 2;
+  else if (builder->token_length >= COAP_TOKEN_EXT_1B_BIAS)
+    size += 1;
+  for (i = 0; i < builder->option_count; i++) {
+    coap_option_num_t number = builder->options[i].number;
+
+    if (i > 0 && number == prev && !coap_option_check_repeatable(number))
+      return NULL;
+    size += coap_opt_encode_size(number - prev, builder->options[i].length);
+    prev = number;
+  }
+  if (builder->data_length)
+    size += 1 + builder->data_length;
+  if (max_size && size > max_size) {
+    coap_log_warn("coap_pdu_builder_build: pdu too big\n");
+    return NULL;
+  }
+
+  pdu = coap_pdu_alloc(builder->type, builder->code, mid,
+                       max_size ? max_size : size, size);
+  if (!pdu)
+    return NULL;
+  if (!coap_add_token(pdu, builder->token_length, builder->token))
+    goto fail;
+
+  opt = pdu->token + pdu->used_size;
+  prev = 0;
+  for (i = 0; i < builder->option_count; i++) {
+    size_t optsize = coap_opt_encode(opt, pdu->alloc_size - pdu->used_size,
+                                     builder->options[i].number - prev,
+                                     builder->options[i].value,
+                                     builder->options[i].length);
+
+    if (!optsize)
+      goto fail;
+    opt += optsize;
+    pdu->used_size += optsize;
+    prev = builder->options[i].number;
+  }
+  pdu->max_opt = prev;
+
+  if (builder->data_length) {
+    pdu->token[pdu->used_size++] = COAP_PAYLOAD_START;
+    pdu->data = pdu->token + pdu->used_size;
+    if (builder->data)
+      memcpy(pdu->data, builder->data, builder->data_length);
+    pdu->used_size += builder->data_length;
+    if (payload)
+      *payload = pdu->data;
+  }
+  return pdu;
+
+fail:
+  coap_delete_pdu(pdu);
+  return NULL;
+}
+
 int
 coap_get_data(const coap_pdu_t *pdu, size_t *len, const uint8_t **data) {
   size_t offset;
@@ -1272,6 +1454,7 @@ coap_pdu_parse_opt(coap_pdu_t *pdu) {
   }
 
   pdu->max_opt = 0;
+  coap_pdu_drop_opt_index(pdu);
   if (pdu->code == 0) {
     /* empty packet */
     pdu->used_size = 0;
@@ -1281,6 +1464,11 @@ coap_pdu_parse_opt(coap_pdu_t *pdu) {
     coap_opt_t *opt = pdu->token + pdu->e_token_length;
     size_t length = pdu->used_size - pdu->e_token_length;
 
+#if COAP_OPTION_INDEX
+    int indexed = 1;
+
+    memset(pdu->opt_index, 0, sizeof(pdu->opt_index));
+#endif /* COAP_OPTION_INDEX */
     while (length > 0 && *opt != COAP_PAYLOAD_START) {
 #if (COAP_MAX_LOGGING_LEVEL >= _COAP_LOG_WARN)
       coap_opt_t *opt_last = opt;
@@ -1295,6 +1483,18 @@ coap_pdu_parse_opt(coap_pdu_t *pdu) {
         good = 0;
         break;
       }
+#if COAP_OPTION_INDEX
+      /* Remember the first instance, repeated options follow it */
+      if (pdu->max_opt < COAP_OPTION_INDEX_SIZE &&
+          pdu->opt_index[pdu->max_opt] == 0) {
+        size_t offset = opt - optsize - pdu->token - pdu->e_token_length;
+
+        if (offset < UINT16_MAX)
+          pdu->opt_index[pdu->max_opt] = (uint16_t)(offset + 1);
+        else
+          indexed = 0;
+      }
+#endif /* COAP_OPTION_INDEX */
       if (COAP_PDU_IS_SIGNALING(pdu) ?
           !coap_pdu_parse_opt_csm(pdu, len) :
           !coap_pdu_parse_opt_base(pdu, len)) {
@@ -1373,6 +1573,10 @@ coap_pdu_parse_opt(coap_pdu_t *pdu) {
       pdu->data = (uint8_t *)opt;
     else
       pdu->data = NULL;
+#if COAP_OPTION_INDEX
+    if (good && indexed)
+      pdu->opt_index_size = pdu->used_size;
+#endif /* COAP_OPTION_INDEX */
   }
 
   return good;
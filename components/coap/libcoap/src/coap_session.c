@@ -474,14 +474,10 @@ coap_session_mfree(coap_session_t *session) {
       /* Need to close down observe */
       if (coap_cancel_observe(session, lg_crcv->app_token, COAP_MESSAGE_NON)) {
         /* Need to delete node we set up for NON */
-        coap_queue_t *queue = session->context->sendqueue;
+        coap_queue_t *queue = coap_find_session_node(session->context, session);
 
-        while (queue) {
-          if (queue->session == session) {
-            coap_delete_node(queue);
-            break;
-          }
-          queue = queue->next;
+        if (queue) {
+          coap_delete_node(queue);
         }
       }
     }
@@ -794,8 +790,9 @@ coap_session_connected(coap_session_t *session) {
                    coap_session_str(session), (int)q->pdu->mid);
     bytes_written = coap_session_send_pdu(session, q->pdu);
     if (q->pdu->type == COAP_MESSAGE_CON && COAP_PROTO_NOT_RELIABLE(session->proto)) {
-      if (coap_wait_ack(session->context, session, q) >= 0)
-        q = NULL;
+      /* coap_wait_ack() keeps q or deletes it on failure */
+      coap_wait_ack(session->context, session, q);
+      q = NULL;
     }
     if (COAP_PROTO_NOT_RELIABLE(session->proto)) {
       if (q)
@@ -860,19 +857,15 @@ coap_session_disconnected(coap_session_t *session, coap_nack_reason_t reason) {
   if (reason == COAP_NACK_ICMP_ISSUE) {
     if (session->context->nack_handler) {
       int sent_nack = 0;
-      coap_queue_t *q = session->context->sendqueue;
-      while (q) {
-        if (q->session == session) {
-          /* Take the first one */
-          coap_bin_const_t token = q->pdu->actual_token;
-
-          coap_check_update_token(session, q->pdu);
-          session->context->nack_handler(session, q->pdu, reason, q->id);
-          coap_update_token(q->pdu, token.length, token.s);
-          sent_nack = 1;
-          break;
-        }
-        q = q->next;
+      /* Take the first one */
+      coap_queue_t *q = coap_find_session_node(session->context, session);
+      if (q) {
+        coap_bin_const_t token = q->pdu->actual_token;
+
+        coap_check_update_token(session, q->pdu);
+        session->context->nack_handler(session, q->pdu, reason, q->id);
+        coap_update_token(q->pdu, token.length, token.s);
+        sent_nack = 1;
       }
 #if COAP_CLIENT_SUPPORT
       if (!sent_nack && session->lg_crcv) {
@@ -1863,13 +1856,18 @@ coap_session_get_by_peer(const coap_context_t *ctx,
 #endif /* COAP_CLIENT_SUPPORT */
 #if COAP_SERVER_SUPPORT
   coap_endpoint_t *ep;
+  coap_addr_hash_t addr_hash;
 
+  /* Server sessions are hashed by remote address, local port and protocol */
+  memset(&addr_hash, 0, sizeof(addr_hash));
+  coap_address_copy(&addr_hash.remote, remote_addr);
   LL_FOREACH(ctx->endpoint, ep) {
-    SESSIONS_ITER(ep->sessions, s, rtmp) {
-      if (s->ifindex == ifindex && coap_address_equals(&s->addr_info.remote,
-                                                       remote_addr))
-        return s;
-    }
+    addr_hash.lport = coap_address_get_port(&ep->bind_addr);
+    addr_hash.proto = ep->proto;
+    s = NULL;
+    SESSIONS_FIND(ep->sessions, addr_hash, s);
+    if (s && s->ifindex == ifindex)
+      return s;
   }
 #endif /* COAP_SERVER_SUPPORT */
   return NULL;
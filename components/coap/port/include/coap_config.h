@@ -38,8 +38,6 @@
 
 #define HAVE_LIMITS_H
 
-#define COAP_RESOURCES_NOHASH
-
 /* Note: If neither of COAP_CLIENT_SUPPORT or COAP_SERVER_SUPPORT is set,
    then libcoap sets both for backward compatability */
 #ifdef CONFIG_COAP_CLIENT_SUPPORT
@@ -88,6 +86,34 @@
 #define COAP_Q_BLOCK_SUPPORT 0
 #endif /* ! CONFIG_COAP_Q_BLOCK */
 
+#ifdef CONFIG_COAP_SENDQUEUE_HEAP
+#define COAP_SENDQUEUE_HEAP 1
+#else /* ! CONFIG_COAP_SENDQUEUE_HEAP */
+#define COAP_SENDQUEUE_HEAP 0
+#endif /* ! CONFIG_COAP_SENDQUEUE_HEAP */
+
+#ifdef CONFIG_COAP_OPTION_INDEX
+#define COAP_OPTION_INDEX 1
+#else /* ! CONFIG_COAP_OPTION_INDEX */
+#define COAP_OPTION_INDEX 0
+#endif /* ! CONFIG_COAP_OPTION_INDEX */
+
+#ifdef CONFIG_COAP_MEM_POOL
+#define COAP_MEM_POOL 1
+#define COAP_MEM_POOL_PDUS CONFIG_COAP_MEM_POOL_PDUS
+#define COAP_MEM_POOL_SMALL_BUFS CONFIG_COAP_MEM_POOL_SMALL_BUFS
+#define COAP_MEM_POOL_LARGE_BUFS CONFIG_COAP_MEM_POOL_LARGE_BUFS
+#define COAP_MEM_POOL_BODY_BUFS CONFIG_COAP_MEM_POOL_BODY_BUFS
+#define COAP_MEM_POOL_BODY_BUF_SIZE CONFIG_COAP_MEM_POOL_BODY_BUF_SIZE
+#define COAP_MEM_POOL_NODES CONFIG_COAP_MEM_POOL_NODES
+#define COAP_MEM_POOL_SESSIONS CONFIG_COAP_MEM_POOL_SESSIONS
+#define COAP_MEM_POOL_LARGE_BODIES CONFIG_COAP_MEM_POOL_LARGE_BODIES
+#define COAP_MEM_POOL_STRINGS CONFIG_COAP_MEM_POOL_STRINGS
+#define COAP_MEM_POOL_LARGE_STRINGS CONFIG_COAP_MEM_POOL_LARGE_STRINGS
+#else /* ! CONFIG_COAP_MEM_POOL */
+#define COAP_MEM_POOL 0
+#endif /* ! CONFIG_COAP_MEM_POOL */
+
 #ifdef CONFIG_COAP_DEBUGGING
 #define COAP_MAX_LOGGING_LEVEL CONFIG_COAP_LOG_DEFAULT_LEVEL
 #else /* ! CONFIG_COAP_DEBUGGING */
@@ -0,0 +1,384 @@
+/**
+ * @file arq_loss_test.c
+ * @brief Host Test of the NACK-driven Retransmission (arq.c) over a simulated Loopback: the Send-Loop of the Sensor
+ * (one live Frame, arq_store_frame(), at most one Retransmission) sends to a Receiver which loses a configurable Set of
+ * Sequence Numbers and answers Gaps with NACKs. Checks that every lost Frame is recovered while it is in the History,
+ * that a longer Burst is reported as unrecoverable, that the Token Bucket limits Retransmissions even under a NACK Flood
+ * and that arq_history_after() resumes a Stream
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "arq.h"
+
+#define TEST_HISTORY_SIZE 4     // ARQ_HISTORY_SIZE of main.c
+#define TEST_RATE 10            // ARQ_RATE of main.c
+#define TEST_BURST 4            // ARQ_BURST of main.c
+#define TEST_FRAME_US 28400     // Frame Interval of FRAME_MODE_THROUGHPUT
+#define TEST_IDLE_US 1000       // Send-Loop Tick without new Frames
+#define TEST_IDLE_TICKS 2000
+#define TEST_FRAMES 300
+#define TEST_MAX_FRAMES 4096
+
+// Lost Frames of the default Run: single Losses and Bursts up to the History Size - 1
+static const uint32_t defaultDrops[] = {5, 17, 18, 40, 41, 42, 90, 150, 151, 152, 260};
+
+/**
+ * @brief Simulated Receiver and Counters of one Run
+ *
+ */
+struct loopback{
+    arq_handle_t *arq;
+    frame_t frames[TEST_MAX_FRAMES];
+    bool dropped[TEST_MAX_FRAMES];
+    bool received[TEST_MAX_FRAMES];
+    uint32_t next;              // Next live Sequence Number the Receiver expects
+    uint32_t newest;            // Newest live Frame of the Sender
+    bool flood;                 // Receiver NACKs the whole History for every Frame
+    uint live;                  // Live Frames send
+    uint retransmitted;
+    uint tooOld;                // Retransmissions of Frames which should have left the History
+    uint errors;
+};
+typedef struct loopback loopback_t;
+
+static loopback_t loop;
+static int64_t clockUs;
+
+int64_t esp_timer_get_time(void)
+{
+    return clockUs;
+}
+
+/**
+ * @brief Send a NACK for first..last like the Receiver, Pairs of Sequence Numbers in NBO
+ *
+ */
+static void send_nack(uint32_t first, uint32_t last)
+{
+    uint32_t message[2] = {htonl(first), htonl(last)};
+    struct in_addr requester = {htonl(INADDR_LOOPBACK)};
+
+    if(arq_parse_nack(loop.arq, (const uint8_t *)message, sizeof(message), requester) < 0)
+    {
+        loop.errors++;
+    }
+}
+
+/**
+ * @brief Loopback: deliver a live Frame unless it is in the Drop Set, a Gap in the live Frames is answered with a NACK
+ *
+ */
+static void deliver_live(frame_t *frame)
+{
+    loop.live++;
+    loop.newest = frame->seq;
+    if(loop.dropped[frame->seq])
+    {
+        return;
+    }
+    loop.received[frame->seq] = true;
+    if(frame->seq != loop.next)
+    {
+        send_nack(loop.next, frame->seq - 1);
+    }
+    loop.next = frame->seq + 1;
+    if(loop.flood)
+    {
+        send_nack(frame->seq >= TEST_HISTORY_SIZE ? frame->seq - TEST_HISTORY_SIZE + 1 : 0, frame->seq);
+    }
+}
+
+/**
+ * @brief send_retransmission() of main.c: at most one Frame from the History
+ *
+ * @return 1 if a Frame was send again // 0 if nothing to send
+ */
+static int retransmit(void)
+{
+    struct in_addr requester;
+    frame_t *frame = arq_next_retransmission(loop.arq, &requester);
+
+    if(frame == NULL)
+    {
+        return 0;
+    }
+    if(loop.newest - frame->seq >= TEST_HISTORY_SIZE)
+    {
+        loop.tooOld++;
+    }
+    if(requester.s_addr != htonl(INADDR_LOOPBACK))
+    {
+        loop.errors++;
+    }
+    loop.retransmitted++;
+    loop.received[frame->seq] = true;
+
+    return 1;
+}
+
+/**
+ * @brief Run the Send-Loop of the Sensor over the Loopback, then idle until all Requests are served
+ *
+ * @param count Live Frames
+ */
+static void run_loop(uint count)
+{
+    loop.arq = init_arq(TEST_HISTORY_SIZE, TEST_RATE, TEST_BURST);
+    for(uint32_t seq = 0; seq < count; seq++)
+    {
+        clockUs += TEST_FRAME_US;
+        loop.frames[seq].seq = seq;
+        deliver_live(&loop.frames[seq]);
+        arq_store_frame(loop.arq, &loop.frames[seq]);
+        // Live Frame first, at most one Retransmission per live Frame
+        retransmit();
+    }
+    // Retransmissions are also send while no new Frame is available
+    loop.flood = false;
+    for(uint i = 0; i < TEST_IDLE_TICKS; i++)
+    {
+        clockUs += TEST_IDLE_US;
+        retransmit();
+    }
+}
+
+/**
+ * @brief Reset the Loopback for the next Run
+ *
+ */
+static void reset_loop(void)
+{
+    if(loop.arq != NULL)
+    {
+        vQueueDelete(loop.arq->requestQueue);
+        free(loop.arq->history);
+        free(loop.arq);
+    }
+    memset(&loop, 0, sizeof(loop));
+    clockUs = 0;
+}
+
+/**
+ * @brief Every dropped Frame must be recovered from the History
+ *
+ * @return -1 if a Frame is missing // 1 if all Frames arrived
+ */
+static int test_loss(const uint32_t *drops, uint dropCount, uint count)
+{
+    uint missing = 0;
+
+    reset_loop();
+    for(uint i = 0; i < dropCount; i++)
+    {
+        loop.dropped[drops[i]] = true;
+    }
+    run_loop(count);
+
+    for(uint32_t seq = 0; seq < count; seq++)
+    {
+        if(!loop.received[seq])
+        {
+            printf("  frame %u not recovered\n", seq);
+            missing++;
+        }
+    }
+    printf("loss:   %u frames, %u dropped, %u retransmitted, %u missing, %u outside history, %u rate limited\n", count,
+           dropCount, loop.retransmitted, missing, loop.tooOld, loop.arq->stats.rateLimited);
+
+    return (missing == 0 && loop.tooOld == 0 && loop.errors == 0 && loop.retransmitted == dropCount) ? 1 : -1;
+}
+
+/**
+ * @brief A Burst longer than the History: the Frame after the Burst reveals the Gap and is stored before the first
+ * Retransmission, so only the newest TEST_HISTORY_SIZE - 1 lost Frames can be recovered. The older ones must be reported
+ * as notInHistory and every other Frame must arrive
+ *
+ * @return -1 if the unrecoverable Loss is not reported as expected // 1 if it is
+ */
+static int test_burst(uint count)
+{
+    uint32_t first = count / 2;
+    uint length = 2 * TEST_HISTORY_SIZE + 2;
+    uint expected = length - (TEST_HISTORY_SIZE - 1);
+    uint missing = 0;
+    uint missingOutside = 0;
+
+    reset_loop();
+    for(uint32_t seq = first; seq < first + length; seq++)
+    {
+        loop.dropped[seq] = true;
+    }
+    run_loop(count);
+
+    for(uint32_t seq = 0; seq < count; seq++)
+    {
+        if(!loop.received[seq])
+        {
+            missing++;
+            missingOutside += (seq < first || seq >= first + length);
+        }
+    }
+    printf("burst:  %u frames lost from %u, %u retransmitted, %u missing, %u reported not in history (expected %u)\n",
+           length, first, loop.retransmitted, missing, loop.arq->stats.notInHistory, expected);
+
+    return (missing == expected && loop.arq->stats.notInHistory == expected && missingOutside == 0 &&
+            loop.retransmitted == length - expected && loop.errors == 0) ? 1 : -1;
+}
+
+/**
+ * @brief A Receiver which NACKs the whole History for every Frame gets no more than the Token Bucket allows and every
+ * live Frame is still send in Time
+ *
+ * @return -1 if the Rate Limit was exceeded or a live Frame was held back // 1 if Retransmissions stayed within Burst + Rate
+ */
+static int test_flood(uint count)
+{
+    uint limit;
+
+    reset_loop();
+    loop.flood = true;
+    run_loop(count);
+
+    limit = TEST_BURST + (uint)((clockUs * TEST_RATE) / 1000000);
+    printf("flood:  %u of %u live frames in %lld ms, %u retransmitted (limit %u), %u rate limited\n",
+           loop.live, count, (long long)clockUs / 1000, loop.retransmitted, limit, loop.arq->stats.rateLimited);
+
+    return (loop.live == count && loop.retransmitted <= limit && loop.tooOld == 0 &&
+            loop.errors == 0) ? 1 : -1;
+}
+
+/**
+ * @brief TCP Resume: the Connection broke after lastAcked, the Frames after it come again from the History
+ *
+ * @return -1 if the resumed Frames are wrong // 1 if they are the lost Tail, oldest first
+ */
+static int test_resume(uint count)
+{
+    frame_t *resume[TEST_HISTORY_SIZE];
+    uint32_t newest = count - 1;
+    int result = 1;
+
+    reset_loop();
+    loop.arq = init_arq(TEST_HISTORY_SIZE, TEST_RATE, TEST_BURST);
+    for(uint32_t seq = 0; seq < count; seq++)
+    {
+        loop.frames[seq].seq = seq;
+        arq_store_frame(loop.arq, &loop.frames[seq]);
+    }
+
+    // Lost Tail of 0 up to the whole History
+    for(uint32_t lost = 0; lost <= TEST_HISTORY_SIZE; lost++)
+    {
+        uint resumed = arq_history_after(loop.arq, newest - lost, resume);
+
+        if(resumed != lost)
+        {
+            result = -1;
+        }
+        for(uint i = 0; i < resumed && i < lost; i++)
+        {
+            if(resume[i]->seq != newest - lost + 1 + i)
+            {
+                result = -1;
+            }
+        }
+    }
+    // Older than the History: only what is left can be resumed
+    if(arq_history_after(loop.arq, newest - 2 * TEST_HISTORY_SIZE, resume) != TEST_HISTORY_SIZE ||
+       resume[0]->seq != newest - TEST_HISTORY_SIZE + 1)
+    {
+        result = -1;
+    }
+    printf("resume: %u frames, history %u, %s\n", count, TEST_HISTORY_SIZE, result > 0 ? "ok" : "wrong frames");
+
+    return result;
+}
+
+/**
+ * @brief Parse a comma separated List of Sequence Numbers
+ *
+ * @return Number of Sequence Numbers // -1 if the List is invalid
+ */
+static int parse_drops(char *list, uint32_t *drops, uint count)
+{
+    int dropCount = 0;
+
+    for(char *token = strtok(list, ","); token != NULL; token = strtok(NULL, ","))
+    {
+        drops[dropCount] = strtoul(token, NULL, 10);
+        // The last Frame has no Successor which reveals its Loss
+        if(drops[dropCount] + 1 >= count || dropCount + 1 == TEST_MAX_FRAMES)
+        {
+            return -1;
+        }
+        dropCount++;
+    }
+
+    return dropCount;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t drops[TEST_MAX_FRAMES];
+    char *dropList = NULL;
+    uint count = TEST_FRAMES;
+    int dropCount = sizeof(defaultDrops) / sizeof(defaultDrops[0]);
+    int failed = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:d:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'd':
+                dropList = optarg;
+                break;
+            default:
+                printf("Usage: %s [-n frames] [-d dropped sequence numbers, e.g. 3,10,11]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(count < 6 * TEST_HISTORY_SIZE || count > TEST_MAX_FRAMES)
+    {
+        printf("%u to %u frames\n", 6 * TEST_HISTORY_SIZE, TEST_MAX_FRAMES);
+        return 1;
+    }
+
+    memcpy(drops, defaultDrops, sizeof(defaultDrops));
+    if(dropList != NULL)
+    {
+        dropCount = parse_drops(dropList, drops, count);
+    }
+    else if(drops[dropCount - 1] + 1 >= count)
+    {
+        dropCount = -1;
+    }
+    if(dropCount < 0)
+    {
+        printf("Dropped frames must be below the last frame %u\n", count - 1);
+        return 1;
+    }
+
+    failed += test_loss(drops, dropCount, count) < 0;
+    failed += test_burst(count) < 0;
+    failed += test_flood(count) < 0;
+    failed += test_resume(count) < 0;
+    reset_loop();
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+
+    return failed ? 1 : 0;
+}
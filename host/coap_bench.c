@@ -0,0 +1,670 @@
+/**
+ * @file coap_bench.c
+ * @brief Host Benchmark of the CoAP Transport: a libcoap Client sends Frames like send_task_coap() to a libcoap Server
+ * over Loopback. Sweeps Frame Size, CON/NON, Block1/Q-Block1 and plain/DTLS-PSK/OSCORE and reports Messages/s, Bytes/s,
+ * Allocations per Message and the p99 Latency, optionally with every n-th Datagram dropped
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <coap3/coap.h>
+
+#define BENCH_PORT 56830
+#define BENCH_DTLS_PORT 56840
+#define BENCH_FRAME_SIZE 5000   // Bytes per Frame, ~ two Ringbuffers of 16-bit Samples
+#define BENCH_TOKEN_SIZE 4      // Token carries the Frame Index, for the Latency
+#define BENCH_MAX_POOLS 12      // Size Classes of the libcoap Pools
+#define BENCH_TOKEN_FLAG 0x80000000 // Keeps the Token apart from the Block State Tokens, libcoap counts them up from 0
+#define BENCH_FRAMES 2000
+#define BENCH_WINDOW 4          // Frames in flight, like COAP_STREAM_NSTART
+#define BENCH_PSK_IDENTITY "sensor"
+#define BENCH_PSK_KEY "bench-psk-0123456789"
+
+/**
+ * @brief Protection of the Frames
+ *
+ */
+enum bench_mode{
+    BENCH_MODE_PLAIN,
+    BENCH_MODE_DTLS,
+    BENCH_MODE_OSCORE,
+};
+typedef enum bench_mode bench_mode_t;
+
+/**
+ * @brief Block Transfer of Frames larger than the PDU
+ *
+ */
+enum bench_block{
+    BENCH_BLOCK_BLOCK1,     // RFC 7959, one Block per Round Trip
+    BENCH_BLOCK_QBLOCK1,    // RFC 9177, Blocks in Bursts, like coap_stream.c
+};
+typedef enum bench_block bench_block_t;
+
+/**
+ * @brief Settings and Counters of one Run
+ *
+ */
+struct bench{
+    bench_mode_t mode;
+    coap_pdu_type_t type;   // COAP_MESSAGE_NON like send_task_coap() or COAP_MESSAGE_CON
+    bench_block_t block;
+    size_t frameSize;
+    uint frames;
+    uint window;
+    uint sent;
+    uint released;          // Frames libcoap is done with (Response, Timeout or Loss), frees a Slot of the Window
+    uint responses;
+    uint errors;
+    uint64_t *sendTimes;    // Send Time of every Frame in us
+    uint32_t *latencies;    // Send to final Response of every answered Frame in us
+    uint latencyCount;
+};
+typedef struct bench bench_t;
+
+static const char *mode_names[] = {"plain", "dtls", "oscore"};
+static const char *block_names[] = {"block1", "qblock1"};
+static const size_t sweep_sizes[] = {64, 512, 1024, 5000, 16000};
+
+// Heap Allocations of this Process (libcoap, OpenSSL, Bench), counted by the malloc Wrappers below
+static uint64_t allocations;
+
+// Loss Injection: every n-th Datagram of each Process is dropped by the send Wrappers below, 0 --> no Loss. The Server
+// Child inherits the Setting, so Requests and Responses are lost
+static uint dropEvery;
+static uint64_t datagrams;
+static uint64_t dropped;
+
+// Pool Failures of all Server Processes, shared with the Children (ENABLE_MEM_POOL)
+static uint *serverFailures;
+
+// OSCORE Security Context, Sender and Recipient are swapped on the Server
+static const char oscore_client_conf[] =
+    "master_secret,hex,\"0102030405060708090a0b0c0d0e0f10\"\n"
+    "master_salt,hex,\"9e7ca92223786340\"\n"
+    "sender_id,hex,\"01\"\n"
+    "recipient_id,hex,\"02\"\n"
+    "ssn_freq,integer,1000\n";
+static const char oscore_server_conf[] =
+    "master_secret,hex,\"0102030405060708090a0b0c0d0e0f10\"\n"
+    "master_salt,hex,\"9e7ca92223786340\"\n"
+    "sender_id,hex,\"02\"\n"
+    "recipient_id,hex,\"01\"\n"
+    "ssn_freq,integer,1000\n";
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Count every Allocation of the Process, the Work is done by glibc
+ *
+ */
+void *malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+/**
+ * @brief Count a Datagram of this Process and decide whether the Loss Injection drops it
+ *
+ * @return true if the Datagram is dropped
+ */
+static bool drop_datagram(void)
+{
+    datagrams++;
+    if(dropEvery == 0 || datagrams % dropEvery != 0)
+    {
+        return false;
+    }
+    dropped++;
+    return true;
+}
+
+/**
+ * @brief Send Wrappers of libcoap (connected Client Socket: send(), Server Endpoint: sendmsg()). A dropped Datagram is
+ * reported as sent, like a Loss on the Link, the Work is done by the C Library
+ *
+ */
+ssize_t send(int fd, const void *buf, size_t len, int flags)
+{
+    static ssize_t (*next)(int, const void *, size_t, int);
+
+    if(drop_datagram())
+    {
+        return len;
+    }
+    if(next == NULL)
+    {
+        next = (ssize_t (*)(int, const void *, size_t, int))dlsym(RTLD_NEXT, "send");
+    }
+    return next(fd, buf, len, flags);
+}
+
+ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    static ssize_t (*next)(int, const struct msghdr *, int);
+    size_t len = 0;
+
+    if(drop_datagram())
+    {
+        for(size_t i = 0; i < msg->msg_iovlen; i++)
+        {
+            len += msg->msg_iov[i].iov_len;
+        }
+        return len;
+    }
+    if(next == NULL)
+    {
+        next = (ssize_t (*)(int, const struct msghdr *, int))dlsym(RTLD_NEXT, "sendmsg");
+    }
+    return next(fd, msg, flags);
+}
+
+/**
+ * @brief Monotonic Time in us
+ *
+ */
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief CPU Time (User + System) of this Process in us
+ *
+ */
+static uint64_t cpu_us(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+/**
+ * @brief POST Handler of the Server, the Body is complete (COAP_BLOCK_SINGLE_BODY)
+ *
+ */
+static void post_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                         const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+}
+
+/**
+ * @brief Server Process: receives Frames on /audio until it is killed
+ *
+ * @param mode Protection of the Frames
+ */
+static void run_server(bench_mode_t mode)
+{
+    coap_context_t *context;
+    coap_address_t address;
+    coap_resource_t *resource;
+    coap_dtls_spsk_t psk;
+    coap_str_const_t conf = {sizeof(oscore_server_conf) - 1, (const uint8_t *)oscore_server_conf};
+    coap_mem_pool_stats_t start[BENCH_MAX_POOLS];
+    coap_mem_pool_stats_t now[BENCH_MAX_POOLS];
+    uint previous[BENCH_MAX_POOLS];
+    uint poolCount;
+
+    context = coap_new_context(NULL);
+    coap_context_set_block_mode(context, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY | COAP_BLOCK_TRY_Q_BLOCK);
+    coap_context_set_max_idle_sessions(context, 4);
+
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(mode == BENCH_MODE_DTLS)
+    {
+        memset(&psk, 0, sizeof(psk));
+        psk.version = COAP_DTLS_SPSK_SETUP_VERSION;
+        psk.psk_info.key.s = (const uint8_t *)BENCH_PSK_KEY;
+        psk.psk_info.key.length = strlen(BENCH_PSK_KEY);
+        coap_context_set_psk2(context, &psk);
+        address.addr.sin.sin_port = htons(BENCH_DTLS_PORT);
+        coap_new_endpoint(context, &address, COAP_PROTO_DTLS);
+    }
+    else
+    {
+        address.addr.sin.sin_port = htons(BENCH_PORT);
+        coap_new_endpoint(context, &address, COAP_PROTO_UDP);
+    }
+    if(mode == BENCH_MODE_OSCORE)
+    {
+        coap_context_oscore_server(context, coap_new_oscore_conf(conf, NULL, NULL, 0));
+    }
+
+    resource = coap_resource_init(coap_make_str_const("audio"), 0);
+    coap_register_request_handler(resource, COAP_REQUEST_POST, post_handler);
+    coap_add_resource(context, resource);
+
+    // The Child starts with the Pool Counters of the Client, only its own Failures are added
+    poolCount = coap_mem_pool_stats(start, BENCH_MAX_POOLS);
+    for(uint i = 0; i < poolCount && serverFailures != NULL; i++)
+    {
+        previous[i] = serverFailures[i];
+    }
+    while(1)
+    {
+        coap_io_process(context, 1000);
+        coap_mem_pool_stats(now, poolCount);
+        for(uint i = 0; i < poolCount && serverFailures != NULL; i++)
+        {
+            serverFailures[i] = previous[i] + now[i].failures - start[i].failures;
+        }
+    }
+}
+
+/**
+ * @brief Compare two Latencies for qsort()
+ *
+ */
+static int compare_latency(const void *a, const void *b)
+{
+    uint32_t first = *(const uint32_t *)a;
+    uint32_t second = *(const uint32_t *)b;
+
+    return (first > second) - (first < second);
+}
+
+/**
+ * @brief Count final Responses, 2.31 Continue is handled inside libcoap. The Token is the Frame Index, libcoap gives
+ * the Token of the Request also for Block Transfers
+ *
+ */
+static coap_response_t response_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received,
+                                        const coap_mid_t mid)
+{
+    bench_t *bench = coap_session_get_app_data(session);
+    coap_bin_const_t token = coap_pdu_get_token(received);
+    uint32_t index;
+
+    if(token.length == BENCH_TOKEN_SIZE)
+    {
+        index = ((uint32_t)token.s[0] << 24 | (uint32_t)token.s[1] << 16 | (uint32_t)token.s[2] << 8 | token.s[3])
+                & ~BENCH_TOKEN_FLAG;
+        if(index < bench->sent && bench->latencyCount < bench->frames)
+        {
+            bench->latencies[bench->latencyCount++] = now_us() - bench->sendTimes[index];
+        }
+    }
+
+    if(COAP_RESPONSE_CLASS(coap_pdu_get_code(received)) == 2)
+    {
+        bench->responses++;
+    }
+    else
+    {
+        bench->errors++;
+    }
+
+    return COAP_RESPONSE_OK;
+}
+
+/**
+ * @brief Count Frames which got no Response
+ *
+ */
+static void nack_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_nack_reason_t reason,
+                         const coap_mid_t mid)
+{
+    bench_t *bench = coap_session_get_app_data(session);
+
+    bench->errors++;
+}
+
+/**
+ * @brief Called by libcoap when the Large-Body Transfer of a Frame is finished or failed, like release_frame_data() in
+ * coap_stream.c
+ *
+ */
+static void release_handler(coap_session_t *session, void *app_ptr)
+{
+    bench_t *bench = coap_session_get_app_data(session);
+
+    bench->released++;
+}
+
+/**
+ * @brief Create the Client Session for the Mode, like open_session() in coap_stream.c
+ *
+ * @param context Client Context
+ * @param mode Protection of the Frames
+ * @return coap_session_t* Session // NULL if Setup failed
+ */
+static coap_session_t *open_session(coap_context_t *context, bench_mode_t mode)
+{
+    coap_address_t server;
+    coap_dtls_cpsk_t psk;
+    coap_str_const_t conf = {sizeof(oscore_client_conf) - 1, (const uint8_t *)oscore_client_conf};
+
+    coap_address_init(&server);
+    server.addr.sin.sin_family = AF_INET;
+    server.addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    switch(mode)
+    {
+        case BENCH_MODE_DTLS:
+            memset(&psk, 0, sizeof(psk));
+            psk.version = COAP_DTLS_CPSK_SETUP_VERSION;
+            psk.psk_info.identity.s = (const uint8_t *)BENCH_PSK_IDENTITY;
+            psk.psk_info.identity.length = strlen(BENCH_PSK_IDENTITY);
+            psk.psk_info.key.s = (const uint8_t *)BENCH_PSK_KEY;
+            psk.psk_info.key.length = strlen(BENCH_PSK_KEY);
+            server.addr.sin.sin_port = htons(BENCH_DTLS_PORT);
+            return coap_new_client_session_psk2(context, NULL, &server, COAP_PROTO_DTLS, &psk);
+        case BENCH_MODE_OSCORE:
+            server.addr.sin.sin_port = htons(BENCH_PORT);
+            return coap_new_client_session_oscore(context, NULL, &server, COAP_PROTO_UDP,
+                                                  coap_new_oscore_conf(conf, NULL, NULL, 0));
+        default:
+            server.addr.sin.sin_port = htons(BENCH_PORT);
+            return coap_new_client_session(context, NULL, &server, COAP_PROTO_UDP);
+    }
+}
+
+/**
+ * @brief Send one Frame as POST with Large-Body Support, like coap_stream_send_frame()
+ *
+ * @param session Client Session
+ * @param type COAP_MESSAGE_NON or COAP_MESSAGE_CON
+ * @param index Frame Index, send as Token
+ * @param data Frame Data
+ * @param length Frame Size in Bytes
+ * @return -1 if send failed // 1 if send successfull
+ */
+static int send_frame(coap_session_t *session, coap_pdu_type_t type, uint32_t index, const uint8_t *data, size_t length)
+{
+    coap_pdu_t *pdu;
+    uint8_t token[BENCH_TOKEN_SIZE] = {(index | BENCH_TOKEN_FLAG) >> 24, index >> 16, index >> 8, index};
+    uint8_t contentType[2];
+
+    pdu = coap_new_pdu(type, COAP_REQUEST_CODE_POST, session);
+    if(pdu == NULL)
+    {
+        return -1;
+    }
+    coap_add_token(pdu, sizeof(token), token);
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 5, (const uint8_t *)"audio");
+    coap_add_option(pdu, COAP_OPTION_CONTENT_TYPE,
+                    coap_encode_var_safe(contentType, sizeof(contentType), COAP_MEDIATYPE_APPLICATION_OCTET_STREAM),
+                    contentType);
+    if(!coap_add_data_large_request(session, pdu, length, data, release_handler, NULL))
+    {
+        coap_delete_pdu(pdu);
+        return -1;
+    }
+
+    return (coap_send(session, pdu) == COAP_INVALID_MID) ? -1 : 1;
+}
+
+/**
+ * @brief Client: sends all Frames with at most window Frames in flight and prints the Result
+ *
+ * @param bench Settings and Counters
+ * @return -1 if the Run failed // 1 if all Frames were answered
+ */
+static int run_client(bench_t *bench)
+{
+    coap_context_t *context;
+    coap_session_t *session;
+    uint8_t *data;
+    uint64_t start;
+    uint64_t cpuStart;
+    uint64_t elapsed;
+    uint64_t cpu;
+    uint64_t deadline;
+    uint64_t allocationStart;
+    uint64_t droppedStart;
+    uint p50 = 0;
+    uint p99 = 0;
+
+    data = malloc(bench->frameSize);
+    bench->sendTimes = calloc(bench->frames, sizeof(uint64_t));
+    bench->latencies = calloc(bench->frames, sizeof(uint32_t));
+    for(size_t i = 0; i < bench->frameSize; i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    context = coap_new_context(NULL);
+    // The Q-Block Probe of an OSCORE Session is only send after the first Response Timeout (5 s), like coap_stream.c
+    coap_context_set_block_mode(context, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY |
+                                         ((bench->block == BENCH_BLOCK_QBLOCK1 && bench->mode != BENCH_MODE_OSCORE)
+                                          ? COAP_BLOCK_TRY_Q_BLOCK : 0));
+    coap_register_response_handler(context, response_handler);
+    coap_register_nack_handler(context, nack_handler);
+    session = open_session(context, bench->mode);
+    if(session == NULL)
+    {
+        fprintf(stderr, "Session Setup failed (%s)\n", mode_names[bench->mode]);
+        return -1;
+    }
+    coap_session_set_app_data(session, bench);
+
+    start = now_us();
+    cpuStart = cpu_us();
+    allocationStart = allocations;
+    droppedStart = dropped;
+    deadline = start + 60000000;
+    while(bench->responses + bench->errors < bench->frames && now_us() < deadline)
+    {
+        while(bench->sent < bench->frames && bench->sent - bench->released < bench->window)
+        {
+            bench->sendTimes[bench->sent] = now_us();
+            if(send_frame(session, bench->type, bench->sent, data, bench->frameSize) < 0)
+            {
+                bench->errors++;
+            }
+            bench->sent++;
+        }
+        coap_io_process(context, 1);
+    }
+    elapsed = now_us() - start;
+    cpu = cpu_us() - cpuStart;
+    allocationStart = allocations - allocationStart;
+
+    if(bench->latencyCount > 0)
+    {
+        qsort(bench->latencies, bench->latencyCount, sizeof(uint32_t), compare_latency);
+        p50 = bench->latencies[bench->latencyCount / 2];
+        p99 = bench->latencies[(bench->latencyCount * 99) / 100];
+    }
+    printf("%-7s %-4s %-8s %6zu %6u %10.1f %8.2f %8.1f %8u %8u %8.1f %6u %7llu\n",
+           mode_names[bench->mode], (bench->type == COAP_MESSAGE_CON) ? "CON" : "NON", block_names[bench->block],
+           bench->frameSize, bench->responses, bench->responses * 1e6 / elapsed,
+           (double)bench->responses * bench->frameSize / elapsed, (double)allocationStart / bench->frames, p50, p99,
+           (double)cpu / bench->frames, bench->errors, (unsigned long long)(dropped - droppedStart));
+
+    coap_session_release(session);
+    coap_free_context(context);
+    free(bench->latencies);
+    free(bench->sendTimes);
+    free(data);
+
+    return (bench->responses == bench->frames) ? 1 : -1;
+}
+
+/**
+ * @brief Run one Mode: Server in a Child Process, Client in this Process
+ *
+ */
+static int run_mode(bench_t *bench)
+{
+    pid_t server;
+    int result;
+
+    // The Child must not print the buffered Lines of the Parent again
+    fflush(stdout);
+    server = fork();
+    if(server == 0)
+    {
+        run_server(bench->mode);
+        _exit(0);
+    }
+    // Server needs its Endpoint before the first Frame
+    usleep(200000);
+    result = run_client(bench);
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+
+    return result;
+}
+
+/**
+ * @brief Pool Counters of the Client Process and Failures of the Server Processes, only with ENABLE_MEM_POOL
+ *
+ */
+static void print_pools(void)
+{
+    coap_mem_pool_stats_t pools[BENCH_MAX_POOLS];
+    uint count = coap_mem_pool_stats(pools, BENCH_MAX_POOLS);
+
+    for(uint i = 0; i < count; i++)
+    {
+        printf("pool %-12s %6zu bytes %4u blocks, high water %4u, failures %u, server failures %u\n", pools[i].name,
+               pools[i].block_size, pools[i].blocks, pools[i].high_water, pools[i].failures,
+               serverFailures != NULL ? serverFailures[i] : 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_t bench;
+    int opt;
+    int first = BENCH_MODE_PLAIN;
+    int last = BENCH_MODE_OSCORE;
+    int firstBlock = BENCH_BLOCK_BLOCK1;
+    int lastBlock = BENCH_BLOCK_QBLOCK1;
+    coap_pdu_type_t types[] = {COAP_MESSAGE_NON, COAP_MESSAGE_CON};
+    uint typeCount = 2;
+    const size_t *sizes = sweep_sizes;
+    uint sizeCount = sizeof(sweep_sizes) / sizeof(sweep_sizes[0]);
+    size_t size;
+    int result = 0;
+
+    memset(&bench, 0, sizeof(bench));
+    bench.frames = BENCH_FRAMES;
+    bench.window = BENCH_WINDOW;
+
+    while((opt = getopt(argc, argv, "m:t:b:s:n:w:l:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'm':
+                for(first = BENCH_MODE_OSCORE; first > BENCH_MODE_PLAIN && strcmp(optarg, mode_names[first]) != 0; first--);
+                last = first;
+                break;
+            case 't':
+                types[0] = (strcmp(optarg, "con") == 0) ? COAP_MESSAGE_CON : COAP_MESSAGE_NON;
+                typeCount = 1;
+                break;
+            case 'b':
+                firstBlock = (strcmp(optarg, "qblock1") == 0) ? BENCH_BLOCK_QBLOCK1 : BENCH_BLOCK_BLOCK1;
+                lastBlock = firstBlock;
+                break;
+            case 's':
+                size = atoi(optarg);
+                sizes = &size;
+                sizeCount = 1;
+                break;
+            case 'n':
+                bench.frames = atoi(optarg);
+                break;
+            case 'w':
+                bench.window = atoi(optarg);
+                break;
+            case 'l':
+                dropEvery = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-m plain|dtls|oscore] [-t non|con] [-b block1|qblock1] [-s frame bytes] [-n frames] "
+                       "[-w frames in flight] [-l drop every n-th datagram]\n", argv[0]);
+                printf("Without -m, -t, -b and -s all Combinations are run, Frame Sizes %zu to %zu Bytes\n",
+                       sweep_sizes[0], sweep_sizes[sizeof(sweep_sizes) / sizeof(sweep_sizes[0]) - 1]);
+                return 1;
+        }
+    }
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_WARN);
+    serverFailures = mmap(NULL, BENCH_MAX_POOLS * sizeof(uint), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(serverFailures == MAP_FAILED)
+    {
+        serverFailures = NULL;
+    }
+    else
+    {
+        memset(serverFailures, 0, BENCH_MAX_POOLS * sizeof(uint));
+    }
+
+    printf("%-7s %-4s %-8s %6s %6s %10s %8s %8s %8s %8s %8s %6s %7s\n", "mode", "type", "block", "bytes", "frames",
+           "msgs/s", "MB/s", "allocs", "p50 us", "p99 us", "CPU us", "errors", "dropped");
+    for(int mode = first; mode <= last; mode++)
+    {
+        for(uint type = 0; type < typeCount; type++)
+        {
+            for(int block = firstBlock; block <= lastBlock; block++)
+            {
+                for(uint i = 0; i < sizeCount; i++)
+                {
+                    bench.mode = mode;
+                    bench.type = types[type];
+                    bench.block = block;
+                    bench.frameSize = sizes[i];
+                    bench.sent = 0;
+                    bench.released = 0;
+                    bench.responses = 0;
+                    bench.errors = 0;
+                    bench.latencyCount = 0;
+                    if(run_mode(&bench) < 0)
+                    {
+                        result = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    print_pools();
+    coap_cleanup();
+
+    return result;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file coap_build_bench.c
+ * @brief Host Microbenchmark of the PDU Construction: builds the same Request with coap_pdu_init() and
+ * coap_add_option() in Application Order (Inserts move the Options, the Buffer grows) and with the
+ * coap_pdu_builder_t (one Allocation of the exact Size, one Encoding Pass). Reports ns and Allocations per PDU
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <coap3/coap.h>
+
+#define BUILD_BENCH_PDUS 1000000
+#define BUILD_BENCH_PAYLOAD 1024
+#define BUILD_BENCH_MAX_SIZE 1152   // coap_session_max_pdu_size() of a UDP Session
+
+// Heap Allocations of this Process, counted by the malloc Wrappers below
+static uint64_t allocations;
+
+static const uint8_t token[8] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+static const uint8_t size1[2] = {0x13, 0x88};
+static const uint8_t contentFormat[1] = {COAP_MEDIATYPE_APPLICATION_OCTET_STREAM};
+static uint8_t payload[BUILD_BENCH_PAYLOAD];
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Count every Allocation of the Process, the Work is done by glibc
+ *
+ */
+void *malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+/**
+ * @brief Monotonic Time in ns
+ *
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief POST /sensor/3/audio?seq=1 with Options in Application Order, coap_add_option() inserts the smaller Numbers
+ *
+ */
+static coap_pdu_t *build_add(void)
+{
+    coap_pdu_t *pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, 1, BUILD_BENCH_MAX_SIZE);
+
+    if(pdu == NULL)
+    {
+        return NULL;
+    }
+    coap_add_token(pdu, sizeof(token), token);
+    coap_add_option(pdu, COAP_OPTION_SIZE1, sizeof(size1), size1);
+    coap_add_option(pdu, COAP_OPTION_CONTENT_FORMAT, sizeof(contentFormat), contentFormat);
+    coap_add_option(pdu, COAP_OPTION_URI_QUERY, 5, (const uint8_t *)"seq=1");
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 6, (const uint8_t *)"sensor");
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 1, (const uint8_t *)"3");
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 5, (const uint8_t *)"audio");
+    coap_add_data(pdu, sizeof(payload), payload);
+
+    return pdu;
+}
+
+/**
+ * @brief Same Request with the Builder
+ *
+ */
+static coap_pdu_t *build_builder(void)
+{
+    coap_pdu_builder_t builder;
+
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_token(&builder, sizeof(token), token);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_SIZE1, sizeof(size1), size1);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_CONTENT_FORMAT, sizeof(contentFormat), contentFormat);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_URI_QUERY, 5, (const uint8_t *)"seq=1");
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_URI_PATH, 6, (const uint8_t *)"sensor");
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_URI_PATH, 1, (const uint8_t *)"3");
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_URI_PATH, 5, (const uint8_t *)"audio");
+    coap_pdu_builder_add_data(&builder, sizeof(payload), payload);
+
+    return coap_pdu_builder_build(&builder, 1, BUILD_BENCH_MAX_SIZE, NULL);
+}
+
+/**
+ * @brief Both Ways must give the same Token, Options and Payload
+ *
+ * @return -1 if the PDUs differ // 1 if they are equal
+ */
+static int compare(const coap_pdu_t *a, const coap_pdu_t *b)
+{
+    coap_opt_iterator_t iteratorA;
+    coap_opt_iterator_t iteratorB;
+    coap_opt_t *optionA;
+    coap_opt_t *optionB;
+    coap_bin_const_t tokenA = coap_pdu_get_token(a);
+    coap_bin_const_t tokenB = coap_pdu_get_token(b);
+    size_t lengthA;
+    size_t lengthB;
+    const uint8_t *dataA;
+    const uint8_t *dataB;
+
+    if(!coap_binary_equal(&tokenA, &tokenB))
+    {
+        return -1;
+    }
+    coap_option_iterator_init(a, &iteratorA, COAP_OPT_ALL);
+    coap_option_iterator_init(b, &iteratorB, COAP_OPT_ALL);
+    do
+    {
+        optionA = coap_option_next(&iteratorA);
+        optionB = coap_option_next(&iteratorB);
+        if((optionA == NULL) != (optionB == NULL))
+        {
+            return -1;
+        }
+        if(optionA != NULL && (iteratorA.number != iteratorB.number ||
+                               coap_opt_length(optionA) != coap_opt_length(optionB) ||
+                               memcmp(coap_opt_value(optionA), coap_opt_value(optionB), coap_opt_length(optionA)) != 0))
+        {
+            return -1;
+        }
+    } while(optionA != NULL);
+
+    if(!coap_get_data(a, &lengthA, &dataA) || !coap_get_data(b, &lengthB, &dataB) || lengthA != lengthB ||
+       memcmp(dataA, dataB, lengthA) != 0)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Build and free count PDUs and print ns and Allocations per PDU
+ *
+ */
+static void run(const char *name, coap_pdu_t *(*build)(void), uint count)
+{
+    uint64_t allocationStart = allocations;
+    uint64_t start = now_ns();
+    uint64_t elapsed;
+
+    for(uint i = 0; i < count; i++)
+    {
+        coap_delete_pdu(build());
+    }
+    elapsed = now_ns() - start;
+
+    printf("%-16s %8.1f ns/pdu %5.1f allocs/pdu\n", name, (double)elapsed / count,
+           (double)(allocations - allocationStart) / count);
+}
+
+int main(int argc, char **argv)
+{
+    uint count = BUILD_BENCH_PDUS;
+    coap_pdu_t *added;
+    coap_pdu_t *built;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-n pdus]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_ERR);
+    memset(payload, 0x55, sizeof(payload));
+
+    added = build_add();
+    built = build_builder();
+    if(added == NULL || built == NULL || compare(added, built) < 0)
+    {
+        printf("Builder PDU differs\n");
+        return 1;
+    }
+    coap_delete_pdu(added);
+    coap_delete_pdu(built);
+
+    run("coap_add_option", build_add, count);
+    run("builder", build_builder, count);
+
+    coap_cleanup();
+
+    return 0;
+}
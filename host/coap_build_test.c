@@ -0,0 +1,351 @@
+/**
+ * @file coap_build_test.c
+ * @brief Host Test of the coap_pdu_builder_t: every Builder PDU has to equal the PDU of coap_pdu_init() and
+ * coap_add_token()/coap_add_option()/coap_add_data() (Header, Token, Options in Order, Payload). Covers repeated Options
+ * in mixed Order, extended Tokens, the Hop-Limit a Proxy Request gets, the reserved Payload and the Error Cases
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <coap3/coap.h>
+
+#define BUILD_TEST_MAX_SIZE 1152    // coap_session_max_pdu_size() of a UDP Session
+#define BUILD_TEST_PAYLOAD 1024
+#define BUILD_TEST_MAX_TOKEN 300
+#define BUILD_TEST_HOP_LIMIT 16     // Hop-Limit which coap_add_option() inserts for a Proxy Request
+
+/**
+ * @brief Option of a Test Request, in the Order the Application adds it
+ *
+ */
+struct test_option{
+    coap_option_num_t number;
+    const char *value;
+};
+typedef struct test_option test_option_t;
+
+// Request of the Sensor in Application Order
+static const test_option_t sensorOptions[] = {
+    {COAP_OPTION_SIZE1, "\x13\x88"},
+    {COAP_OPTION_CONTENT_FORMAT, "\x2A"},
+    {COAP_OPTION_URI_QUERY, "seq=1"},
+    {COAP_OPTION_URI_PATH, "sensor"},
+    {COAP_OPTION_URI_PATH, "3"},
+    {COAP_OPTION_URI_PATH, "audio"},
+};
+
+// Repeated Options mixed with others, each Number has to keep its Order
+static const test_option_t repeatedOptions[] = {
+    {COAP_OPTION_URI_PATH, "sensor"},
+    {COAP_OPTION_URI_QUERY, "seq=1"},
+    {COAP_OPTION_ETAG, "\x22"},
+    {COAP_OPTION_URI_PATH, "3"},
+    {COAP_OPTION_URI_QUERY, "mode=2"},
+    {COAP_OPTION_ETAG, "\x11"},
+    {COAP_OPTION_URI_PATH, "audio"},
+    {COAP_OPTION_NORESPONSE, "\x02"},
+    {COAP_OPTION_IF_MATCH, ""},
+};
+
+// Proxy Request without Hop-Limit
+static const test_option_t proxyOptions[] = {
+    {COAP_OPTION_PROXY_URI, "coap://collector/audio"},
+    {COAP_OPTION_CONTENT_FORMAT, "\x2A"},
+};
+
+// Proxy Request with its own Hop-Limit
+static const test_option_t hopLimitOptions[] = {
+    {COAP_OPTION_HOP_LIMIT, "\x05"},
+    {COAP_OPTION_PROXY_SCHEME, "coap"},
+    {COAP_OPTION_URI_PATH, "audio"},
+};
+
+// Token Lengths: plain, 1 Byte and 2 Byte Extension (RFC 8974)
+static const size_t tokenLengths[] = {0, 4, 8, 13, 20, 268, 269, BUILD_TEST_MAX_TOKEN};
+
+static uint8_t token[BUILD_TEST_MAX_TOKEN];
+static uint8_t payload[BUILD_TEST_PAYLOAD];
+
+/**
+ * @brief Build the Request with coap_pdu_init() and coap_add_option() in Application Order
+ *
+ */
+static coap_pdu_t *build_add(size_t tokenLength, const test_option_t *options, uint optionCount, size_t dataLength)
+{
+    coap_pdu_t *pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, 0x1234, BUILD_TEST_MAX_SIZE);
+
+    if(pdu == NULL || !coap_add_token(pdu, tokenLength, token))
+    {
+        coap_delete_pdu(pdu);
+        return NULL;
+    }
+    for(uint i = 0; i < optionCount; i++)
+    {
+        if(!coap_add_option(pdu, options[i].number, strlen(options[i].value), (const uint8_t *)options[i].value))
+        {
+            coap_delete_pdu(pdu);
+            return NULL;
+        }
+    }
+    if(dataLength > 0 && !coap_add_data(pdu, dataLength, payload))
+    {
+        coap_delete_pdu(pdu);
+        return NULL;
+    }
+
+    return pdu;
+}
+
+/**
+ * @brief Same Request with the Builder
+ *
+ */
+static coap_pdu_t *build_builder(size_t tokenLength, const test_option_t *options, uint optionCount,
+                                 size_t dataLength)
+{
+    coap_pdu_builder_t builder;
+
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_token(&builder, tokenLength, token);
+    for(uint i = 0; i < optionCount; i++)
+    {
+        coap_pdu_builder_add_option(&builder, options[i].number, strlen(options[i].value),
+                                    (const uint8_t *)options[i].value);
+    }
+    coap_pdu_builder_add_data(&builder, dataLength, payload);
+
+    return coap_pdu_builder_build(&builder, 0x1234, BUILD_TEST_MAX_SIZE, NULL);
+}
+
+/**
+ * @brief Both Ways must give the same Header, Token, Options and Payload
+ *
+ * @return -1 if the PDUs differ // 1 if they are equal
+ */
+static int compare(const coap_pdu_t *a, const coap_pdu_t *b)
+{
+    coap_opt_iterator_t iteratorA;
+    coap_opt_iterator_t iteratorB;
+    coap_opt_t *optionA;
+    coap_opt_t *optionB;
+    coap_bin_const_t tokenA = coap_pdu_get_token(a);
+    coap_bin_const_t tokenB = coap_pdu_get_token(b);
+    size_t lengthA = 0;
+    size_t lengthB = 0;
+    const uint8_t *dataA = NULL;
+    const uint8_t *dataB = NULL;
+
+    if(coap_pdu_get_type(a) != coap_pdu_get_type(b) || coap_pdu_get_code(a) != coap_pdu_get_code(b) ||
+       coap_pdu_get_mid(a) != coap_pdu_get_mid(b) || !coap_binary_equal(&tokenA, &tokenB))
+    {
+        return -1;
+    }
+    coap_option_iterator_init(a, &iteratorA, COAP_OPT_ALL);
+    coap_option_iterator_init(b, &iteratorB, COAP_OPT_ALL);
+    do
+    {
+        optionA = coap_option_next(&iteratorA);
+        optionB = coap_option_next(&iteratorB);
+        if((optionA == NULL) != (optionB == NULL))
+        {
+            return -1;
+        }
+        if(optionA != NULL && (iteratorA.number != iteratorB.number ||
+                               coap_opt_length(optionA) != coap_opt_length(optionB) ||
+                               memcmp(coap_opt_value(optionA), coap_opt_value(optionB), coap_opt_length(optionA)) != 0))
+        {
+            return -1;
+        }
+    } while(optionA != NULL);
+
+    if(coap_get_data(a, &lengthA, &dataA) != coap_get_data(b, &lengthB, &dataB) || lengthA != lengthB ||
+       (lengthA > 0 && memcmp(dataA, dataB, lengthA) != 0))
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Build a Request both Ways and compare them
+ *
+ * @return -1 if a Build failed or the PDUs differ // 1 if they are equal
+ */
+static int test_equal(const char *name, size_t tokenLength, const test_option_t *options, uint optionCount,
+                      size_t dataLength)
+{
+    coap_pdu_t *added = build_add(tokenLength, options, optionCount, dataLength);
+    coap_pdu_t *built = build_builder(tokenLength, options, optionCount, dataLength);
+    int result = (added != NULL && built != NULL && compare(added, built) > 0) ? 1 : -1;
+
+    if(result < 0)
+    {
+        printf("%s, token %zu, payload %zu: builder PDU differs\n", name, tokenLength, dataLength);
+    }
+    coap_delete_pdu(added);
+    coap_delete_pdu(built);
+
+    return result;
+}
+
+/**
+ * @brief Value of the only Hop-Limit Option of a PDU
+ *
+ * @return Hop-Limit // -1 if there is none or more than one
+ */
+static int get_hop_limit(const coap_pdu_t *pdu)
+{
+    coap_opt_iterator_t iterator;
+    coap_opt_t *option = coap_check_option(pdu, COAP_OPTION_HOP_LIMIT, &iterator);
+
+    if(option == NULL || coap_opt_length(option) != 1 || coap_option_next(&iterator) != NULL)
+    {
+        return -1;
+    }
+
+    return *coap_opt_value(option);
+}
+
+/**
+ * @brief A Proxy Request gets Hop-Limit 16 like with coap_add_option(), an own Hop-Limit is kept
+ *
+ * @return -1 if the Hop-Limit is wrong // 1 if it is right
+ */
+static int test_hop_limit(void)
+{
+    coap_pdu_builder_t builder;
+    coap_pdu_t *pdu;
+    int hopLimit;
+    int result = 1;
+
+    if(test_equal("proxy", 8, proxyOptions, sizeof(proxyOptions) / sizeof(proxyOptions[0]), 0) < 0)
+    {
+        result = -1;
+    }
+    pdu = build_builder(8, proxyOptions, sizeof(proxyOptions) / sizeof(proxyOptions[0]), 0);
+    hopLimit = (pdu != NULL) ? get_hop_limit(pdu) : -1;
+    if(hopLimit != BUILD_TEST_HOP_LIMIT)
+    {
+        printf("proxy: hop limit %d instead of %d\n", hopLimit, BUILD_TEST_HOP_LIMIT);
+        result = -1;
+    }
+    coap_delete_pdu(pdu);
+
+    if(test_equal("hop limit", 8, hopLimitOptions, sizeof(hopLimitOptions) / sizeof(hopLimitOptions[0]), 0) < 0)
+    {
+        result = -1;
+    }
+    // The Builder keeps the own Hop-Limit also if it is added after the Proxy Option
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_CON, COAP_REQUEST_CODE_GET);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_PROXY_SCHEME, 4, (const uint8_t *)"coap");
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_HOP_LIMIT, 1, (const uint8_t *)"\x05");
+    pdu = coap_pdu_builder_build(&builder, 1, BUILD_TEST_MAX_SIZE, NULL);
+    hopLimit = (pdu != NULL) ? get_hop_limit(pdu) : -1;
+    if(hopLimit != 5)
+    {
+        printf("hop limit after proxy-scheme: %d instead of 5\n", hopLimit);
+        result = -1;
+    }
+    coap_delete_pdu(pdu);
+
+    return result;
+}
+
+/**
+ * @brief Reserved Payload, Size Limit and a repeated non-repeatable Option
+ *
+ * @return -1 if a Case is handled wrong // 1 if all are right
+ */
+static int test_builder_cases(void)
+{
+    coap_pdu_builder_t builder;
+    coap_pdu_t *pdu;
+    uint8_t *reserved = NULL;
+    const uint8_t *data;
+    size_t length;
+    int result = 1;
+
+    // NULL Data reserves the Payload, the Caller fills it
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_token(&builder, 8, token);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_URI_PATH, 5, (const uint8_t *)"audio");
+    coap_pdu_builder_add_data(&builder, BUILD_TEST_PAYLOAD, NULL);
+    pdu = coap_pdu_builder_build(&builder, 1, BUILD_TEST_MAX_SIZE, &reserved);
+    if(pdu == NULL || reserved == NULL)
+    {
+        printf("reserved payload: build failed\n");
+        result = -1;
+    }
+    else
+    {
+        memcpy(reserved, payload, BUILD_TEST_PAYLOAD);
+        if(!coap_get_data(pdu, &length, &data) || length != BUILD_TEST_PAYLOAD || data != reserved)
+        {
+            printf("reserved payload: wrong payload\n");
+            result = -1;
+        }
+    }
+    coap_delete_pdu(pdu);
+
+    // Larger than max_size
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_data(&builder, BUILD_TEST_MAX_SIZE, payload);
+    pdu = coap_pdu_builder_build(&builder, 1, BUILD_TEST_MAX_SIZE, NULL);
+    if(pdu != NULL)
+    {
+        printf("too large: PDU built\n");
+        result = -1;
+    }
+    coap_delete_pdu(pdu);
+
+    // Content-Format is not repeatable
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_CONTENT_FORMAT, 1, (const uint8_t *)"\x2A");
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_CONTENT_FORMAT, 1, (const uint8_t *)"\x00");
+    pdu = coap_pdu_builder_build(&builder, 1, BUILD_TEST_MAX_SIZE, NULL);
+    if(pdu != NULL)
+    {
+        printf("repeated content-format: PDU built\n");
+        result = -1;
+    }
+    coap_delete_pdu(pdu);
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_EMERG);
+    for(uint i = 0; i < sizeof(token); i++)
+    {
+        token[i] = (uint8_t)(i + 1);
+    }
+    memset(payload, 0x55, sizeof(payload));
+
+    for(uint i = 0; i < sizeof(tokenLengths) / sizeof(tokenLengths[0]); i++)
+    {
+        failed += test_equal("sensor", tokenLengths[i], sensorOptions, sizeof(sensorOptions) / sizeof(sensorOptions[0]),
+                             BUILD_TEST_PAYLOAD / 2) < 0;
+        failed += test_equal("repeated", tokenLengths[i], repeatedOptions,
+                             sizeof(repeatedOptions) / sizeof(repeatedOptions[0]), 0) < 0;
+    }
+    failed += test_equal("sensor", 8, sensorOptions, sizeof(sensorOptions) / sizeof(sensorOptions[0]),
+                         BUILD_TEST_PAYLOAD) < 0;
+    failed += test_equal("empty", 0, NULL, 0, 0) < 0;
+    failed += test_hop_limit() < 0;
+    failed += test_builder_cases() < 0;
+
+    coap_cleanup();
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+
+    return failed ? 1 : 0;
+}
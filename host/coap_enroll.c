@@ -0,0 +1,357 @@
+/**
+ * @file coap_enroll.c
+ * @brief Collector Side of the CoAP Discovery (COAP_DISCOVERY): finds all Sensors in the All-CoAP-Nodes Group with
+ * GET /.well-known/core?rt=audio-sensor and enrolls them in bulk with CON PUT /config/enroll
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <coap3/coap.h>
+
+#define ENROLL_GROUP "224.0.1.187"  // All-CoAP-Nodes, COAP_CONTROL_GROUP of the Sensor
+#define ENROLL_PORT 5685            // COAP_CONTROL_PORT of the Sensor
+#define ENROLL_DATA_PORT 50001      // Data-Port of this Collector, same for every Sensor
+#define ENROLL_WAIT_S 6             // Sensors delay Multicast Responses by up to DEFAULT_LEISURE (5 s)
+#define ENROLL_MAX_SENSORS 255      // SensorID is one Byte
+
+/**
+ * @brief One discovered Sensor
+ *
+ */
+struct sensor{
+    coap_address_t address;
+    coap_session_t *session;
+    uint8_t sensorID;
+    bool enrolled;
+    bool started;
+};
+typedef struct sensor sensor_t;
+
+/**
+ * @brief Discovered Sensors and Settings of the Enrollment
+ *
+ */
+struct enroll{
+    sensor_t sensors[ENROLL_MAX_SENSORS];
+    uint count;
+    uint pending;           // CON Requests without Response
+    uint errors;
+    uint16_t port;          // COAP_CONTROL_PORT of the Sensors
+    uint16_t dataPort;
+    uint8_t firstID;
+};
+typedef struct enroll enroll_t;
+
+static enroll_t enroll;
+
+/**
+ * @brief Monotonic Time in us
+ *
+ */
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Find the Sensor which belongs to a unicast Session
+ *
+ */
+static sensor_t *find_sensor(coap_session_t *session)
+{
+    for(uint i = 0; i < enroll.count; i++)
+    {
+        if(enroll.sensors[i].session == session)
+        {
+            return &enroll.sensors[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Remember every Sensor which answers the Discovery with /config/enroll. Each Sensor answers once, the Source
+ * Address of the Response is the Sensor
+ *
+ */
+static void discovered(coap_session_t *session, const coap_pdu_t *received)
+{
+    const coap_address_t *remote = coap_session_get_addr_remote(session);
+    size_t length;
+    const uint8_t *data;
+    char links[512];
+    char address[INET6_ADDRSTRLEN];
+
+    if(!coap_get_data(received, &length, &data))
+    {
+        return;
+    }
+    length = length < sizeof(links) ? length : sizeof(links) - 1;
+    memcpy(links, data, length);
+    links[length] = '\0';
+    if(strstr(links, "</config/enroll>") == NULL)
+    {
+        return;
+    }
+
+    for(uint i = 0; i < enroll.count; i++)
+    {
+        if(coap_address_equals(&enroll.sensors[i].address, remote))
+        {
+            return;
+        }
+    }
+
+    if(enroll.count == ENROLL_MAX_SENSORS)
+    {
+        enroll.errors++;
+        return;
+    }
+
+    coap_address_copy(&enroll.sensors[enroll.count].address, remote);
+    enroll.sensors[enroll.count].sensorID = enroll.firstID + enroll.count;
+    printf("Found %s, SensorID %u\n", inet_ntop(AF_INET, &remote->addr.sin.sin_addr, address, sizeof(address)),
+           enroll.sensors[enroll.count].sensorID);
+    enroll.count++;
+}
+
+/**
+ * @brief Discovery Responses on the Multicast Session, Enrollment and Start Responses on the unicast Sessions
+ *
+ */
+static coap_response_t response_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received,
+                                        const coap_mid_t mid)
+{
+    sensor_t *sensor = find_sensor(session);
+
+    if(sensor == NULL)
+    {
+        discovered(session, received);
+        return COAP_RESPONSE_OK;
+    }
+
+    enroll.pending--;
+    if(coap_pdu_get_code(received) != COAP_RESPONSE_CODE_CHANGED)
+    {
+        enroll.errors++;
+    }
+    else if(!sensor->enrolled)
+    {
+        sensor->enrolled = true;
+    }
+    else
+    {
+        sensor->started = true;
+    }
+
+    return COAP_RESPONSE_OK;
+}
+
+/**
+ * @brief CON Request to a Sensor which gave up after all Retransmissions
+ *
+ */
+static void nack_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_nack_reason_t reason,
+                         const coap_mid_t mid)
+{
+    if(find_sensor(session) != NULL)
+    {
+        enroll.pending--;
+        enroll.errors++;
+    }
+}
+
+/**
+ * @brief Send a Request with Text Payload to path
+ *
+ * @param session Session to the Sensor or the Group
+ * @param type COAP_MESSAGE_CON for unicast, COAP_MESSAGE_NON for Multicast
+ * @param code Method
+ * @param path Uri-Path, Segments separated by '/', may end with ?Query
+ * @param text Payload, NULL --> none
+ * @return -1 if send failed // 1 if send successfull
+ */
+static int send_request(coap_session_t *session, coap_pdu_type_t type, coap_pdu_code_t code, const char *path,
+                        const char *text)
+{
+    coap_pdu_t *pdu;
+    uint8_t token[8];
+    size_t tokenLength;
+    const char *query = strchr(path, '?');
+    const char *segment;
+    size_t length;
+
+    pdu = coap_pdu_init(type, code, coap_new_message_id(session), coap_session_max_pdu_size(session));
+    if(pdu == NULL)
+    {
+        return -1;
+    }
+    coap_session_new_token(session, &tokenLength, token);
+    coap_add_token(pdu, tokenLength, token);
+    // Uri-Path (11) before Uri-Query (15), one Option per Segment
+    for(segment = path; *segment != '\0' && *segment != '?'; segment += length + (segment[length] == '/'))
+    {
+        length = strcspn(segment, "/?");
+        coap_add_option(pdu, COAP_OPTION_URI_PATH, length, (const uint8_t *)segment);
+    }
+    if(query != NULL)
+    {
+        coap_add_option(pdu, COAP_OPTION_URI_QUERY, strlen(query + 1), (const uint8_t *)query + 1);
+    }
+    if(text != NULL)
+    {
+        coap_add_data(pdu, strlen(text), (const uint8_t *)text);
+    }
+
+    return coap_send(session, pdu) == COAP_INVALID_MID ? -1 : 1;
+}
+
+/**
+ * @brief Run the I/O Loop until all CON Requests are answered or have failed
+ *
+ */
+static void wait_pending(coap_context_t *context)
+{
+    while(enroll.pending > 0)
+    {
+        coap_io_process(context, 1000);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    coap_context_t *context;
+    coap_session_t *group;
+    coap_address_t address;
+    sensor_t *sensor;
+    char value[16];
+    const char *groupName = ENROLL_GROUP;
+    uint waitS = ENROLL_WAIT_S;
+    bool start = false;
+    uint64_t end;
+    uint enrolled = 0;
+    int opt;
+
+    memset(&enroll, 0, sizeof(enroll));
+    enroll.port = ENROLL_PORT;
+    enroll.dataPort = ENROLL_DATA_PORT;
+    enroll.firstID = 1;
+
+    while((opt = getopt(argc, argv, "g:c:p:f:w:sh")) != -1)
+    {
+        switch(opt)
+        {
+            case 'g':
+                groupName = optarg;
+                break;
+            case 'c':
+                enroll.port = atoi(optarg);
+                break;
+            case 'p':
+                enroll.dataPort = atoi(optarg);
+                break;
+            case 'f':
+                enroll.firstID = atoi(optarg);
+                break;
+            case 'w':
+                waitS = atoi(optarg);
+                break;
+            case 's':
+                start = true;
+                break;
+            default:
+                printf("Usage: %s [-g group] [-c control port] [-p data port] [-f first SensorID] [-w discovery seconds] "
+                       "[-s start measurement]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_WARN);
+
+    context = coap_new_context(NULL);
+    if(context == NULL)
+    {
+        return 1;
+    }
+    coap_register_response_handler(context, response_handler);
+    coap_register_nack_handler(context, nack_handler);
+
+    // Discovery: one NON GET to the Group, every Sensor answers after a random Delay
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_port = htons(enroll.port);
+    if(inet_pton(AF_INET, groupName, &address.addr.sin.sin_addr) != 1)
+    {
+        printf("Invalid group %s\n", groupName);
+        return 1;
+    }
+    group = coap_new_client_session(context, NULL, &address, COAP_PROTO_UDP);
+    if(group == NULL || send_request(group, COAP_MESSAGE_NON, COAP_REQUEST_CODE_GET,
+                                     ".well-known/core?rt=audio-sensor", NULL) < 0)
+    {
+        printf("Discovery in %s failed\n", groupName);
+        return 1;
+    }
+    end = now_us() + (uint64_t)waitS * 1000000;
+    while(now_us() < end)
+    {
+        coap_io_process(context, (end - now_us()) / 1000 + 1);
+    }
+    printf("%u sensors found in %s\n", enroll.count, groupName);
+
+    // Enrollment: CON PUT to every Sensor in parallel, libcoap retransmits lost Requests
+    for(uint i = 0; i < enroll.count; i++)
+    {
+        sensor = &enroll.sensors[i];
+        sensor->session = coap_new_client_session(context, NULL, &sensor->address, COAP_PROTO_UDP);
+        snprintf(value, sizeof(value), "%u %u", sensor->sensorID, enroll.dataPort);
+        if(sensor->session == NULL || send_request(sensor->session, COAP_MESSAGE_CON, COAP_REQUEST_CODE_PUT,
+                                                   "config/enroll", value) < 0)
+        {
+            enroll.errors++;
+            continue;
+        }
+        enroll.pending++;
+    }
+    wait_pending(context);
+
+    for(uint i = 0; i < enroll.count; i++)
+    {
+        enrolled += enroll.sensors[i].enrolled;
+    }
+    printf("%u sensors enrolled to data port %u, %u errors\n", enrolled, enroll.dataPort, enroll.errors);
+
+    if(start)
+    {
+        for(uint i = 0; i < enroll.count; i++)
+        {
+            sensor = &enroll.sensors[i];
+            if(sensor->enrolled && send_request(sensor->session, COAP_MESSAGE_CON, COAP_REQUEST_CODE_PUT,
+                                                "control/start", NULL) > 0)
+            {
+                enroll.pending++;
+            }
+        }
+        wait_pending(context);
+        printf("Measurement started, %u errors\n", enroll.errors);
+    }
+
+    coap_free_context(context);
+    coap_cleanup();
+
+    return enroll.errors > 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file coap_hash_bench.c
+ * @brief Host Microbenchmark of the libcoap Lookups of a Collector: n Resources (coap_get_resource_from_uri_path()) and
+ * n Server Sessions (coap_session_get_by_peer()), both hashed with coap_hash_word(). Reports Lookups per second
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <coap3/coap.h>
+
+#define HASH_BENCH_PORT 56850
+#define HASH_BENCH_COUNT 1000       // Resources and Sessions
+#define HASH_BENCH_LOOKUPS 2000000  // Lookups per Measurement
+#define HASH_BENCH_PATH_SIZE 32
+
+/**
+ * @brief Monotonic Time in ns
+ *
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Add count Resources like a Collector with one Resource Tree per Sensor and look them up in turn
+ *
+ * @return -1 if a Lookup failed // 1 if the Line was printed
+ */
+static int bench_resources(coap_context_t *context, uint count)
+{
+    char (*paths)[HASH_BENCH_PATH_SIZE] = calloc(count, HASH_BENCH_PATH_SIZE);
+    coap_str_const_t *keys = calloc(count, sizeof(coap_str_const_t));
+    coap_resource_t *resource;
+    uint64_t start;
+    uint64_t elapsed;
+    uint found = 0;
+
+    if(paths == NULL || keys == NULL)
+    {
+        free(paths);
+        free(keys);
+        return -1;
+    }
+    for(uint i = 0; i < count; i++)
+    {
+        snprintf(paths[i], HASH_BENCH_PATH_SIZE, "sensor/%u/audio", i);
+        keys[i].s = (const uint8_t *)paths[i];
+        keys[i].length = strlen(paths[i]);
+        resource = coap_resource_init(&keys[i], 0);
+        coap_add_resource(context, resource);
+    }
+
+    start = now_ns();
+    for(uint i = 0; i < HASH_BENCH_LOOKUPS; i++)
+    {
+        found += coap_get_resource_from_uri_path(context, &keys[i % count]) != NULL;
+    }
+    elapsed = now_ns() - start;
+
+    printf("resources %6u %12.0f lookups/s %8.1f ns/lookup\n", count, HASH_BENCH_LOOKUPS * 1e9 / elapsed,
+           (double)elapsed / HASH_BENCH_LOOKUPS);
+    free(paths);
+    free(keys);
+
+    return found == HASH_BENCH_LOOKUPS ? 1 : -1;
+}
+
+/**
+ * @brief Let count Peers send one NON Request each, so the Server holds count Sessions, and look them up by Peer
+ *
+ * @return -1 if a Session is missing // 1 if the Line was printed
+ */
+static int bench_sessions(coap_context_t *context, const coap_address_t *server, uint count)
+{
+    // NON GET /, Message ID 1, no Token
+    static const uint8_t request[] = {0x50, 0x01, 0x00, 0x01};
+    coap_address_t *peers = calloc(count, sizeof(coap_address_t));
+    socklen_t length;
+    uint64_t start;
+    uint64_t elapsed;
+    uint found = 0;
+    int ifindex = if_nametoindex("lo");    // Sessions remember the Interface of the Request
+    int sock;
+
+    if(peers == NULL)
+    {
+        return -1;
+    }
+    for(uint i = 0; i < count; i++)
+    {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        length = sizeof(peers[i].addr.sin);
+        coap_address_init(&peers[i]);
+        // Connected, so getsockname() returns the Loopback Address and not INADDR_ANY
+        connect(sock, &server->addr.sa, server->size);
+        send(sock, request, sizeof(request), 0);
+        getsockname(sock, &peers[i].addr.sa, &length);
+        peers[i].size = length;
+        close(sock);
+        // libcoap reads one Datagram per Socket and Call
+        coap_io_process(context, COAP_IO_NO_WAIT);
+    }
+
+    start = now_ns();
+    for(uint i = 0; i < HASH_BENCH_LOOKUPS; i++)
+    {
+        found += coap_session_get_by_peer(context, &peers[i % count], ifindex) != NULL;
+    }
+    elapsed = now_ns() - start;
+
+    printf("sessions  %6u %12.0f lookups/s %8.1f ns/lookup, %u of %u peers found\n", count,
+           HASH_BENCH_LOOKUPS * 1e9 / elapsed, (double)elapsed / HASH_BENCH_LOOKUPS, found / (HASH_BENCH_LOOKUPS / count),
+           count);
+    free(peers);
+
+    return found == HASH_BENCH_LOOKUPS ? 1 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    coap_context_t *context;
+    coap_address_t address;
+    uint count = HASH_BENCH_COUNT;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-n resources and sessions]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(count == 0 || count > 4000)
+    {
+        printf("1 to 4000 resources and sessions\n");
+        return 1;
+    }
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_ERR);
+
+    context = coap_new_context(NULL);
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_port = htons(HASH_BENCH_PORT);
+    address.addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(context == NULL || coap_new_endpoint(context, &address, COAP_PROTO_UDP) == NULL)
+    {
+        printf("Server on port %u failed\n", HASH_BENCH_PORT);
+        return 1;
+    }
+    // Sessions of idle Peers stay for the whole Benchmark
+    coap_context_set_session_timeout(context, 3600);
+    coap_context_set_max_idle_sessions(context, count + 1);
+
+    if(bench_resources(context, count) < 0 || bench_sessions(context, &address, count) < 0)
+    {
+        printf("Lookup failed\n");
+    }
+
+    coap_free_context(context);
+    coap_cleanup();
+
+    return 0;
+}
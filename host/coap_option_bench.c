@@ -0,0 +1,127 @@
+/**
+ * @file coap_option_bench.c
+ * @brief Host Microbenchmark of the Option Lookups of a Collector: parses a Q-Block1 Request of the Sensor with
+ * coap_pdu_parse() and asks for the Options in the Order the libcoap Request Path does (coap_check_option()). Compare a
+ * Build with ENABLE_OPTION_INDEX OFF and ON
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <coap3/coap.h>
+
+#define OPTION_BENCH_REQUESTS 2000000
+#define OPTION_BENCH_PAYLOAD 1024
+#define OPTION_BENCH_HEADER 27  // Header, Token, Options and Payload Marker of the Request below
+
+// Lookups of the Server per Q-Block1 Request, taken from coap_net.c and coap_block.c
+static const coap_option_num_t lookups[] = {
+    COAP_OPTION_OSCORE, COAP_OPTION_PROXY_URI, COAP_OPTION_PROXY_SCHEME, COAP_OPTION_HOP_LIMIT, COAP_OPTION_Q_BLOCK1,
+    COAP_OPTION_BLOCK1, COAP_OPTION_SIZE1, COAP_OPTION_IF_NONE_MATCH, COAP_OPTION_CONTENT_FORMAT,
+    COAP_OPTION_NORESPONSE, COAP_OPTION_RTAG, COAP_OPTION_Q_BLOCK1, COAP_OPTION_PROXY_URI,
+};
+
+/**
+ * @brief Monotonic Time in ns
+ *
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief NON POST /audio like send_task_coap(): first Q-Block1 Block of a 5000 Byte Frame
+ *
+ * @return Length of the Datagram
+ */
+static size_t build_request(uint8_t *datagram)
+{
+    static const uint8_t header[OPTION_BENCH_HEADER] = {
+        0x58, 0x02, 0x00, 0x01,                          // NON POST, Message ID 1, Token Length 8
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,  // Token
+        0xB5, 'a', 'u', 'd', 'i', 'o',                  // Uri-Path (11)
+        0x11, 0x2A,                                      // Content-Format (12) application/octet-stream
+        0x71, 0x0E,                                      // Q-Block1 (19) Block 0, More, 1024 Bytes
+        0xD2, 0x1C, 0x13, 0x88,                          // Size1 (60) 5000
+        0xFF,                                            // Payload Marker
+    };
+
+    memcpy(datagram, header, OPTION_BENCH_HEADER);
+    memset(datagram + OPTION_BENCH_HEADER, 0x55, OPTION_BENCH_PAYLOAD);
+
+    return OPTION_BENCH_HEADER + OPTION_BENCH_PAYLOAD;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t datagram[OPTION_BENCH_HEADER + OPTION_BENCH_PAYLOAD];
+    size_t length = build_request(datagram);
+    uint lookupCount = sizeof(lookups) / sizeof(lookups[0]);
+    uint requests = OPTION_BENCH_REQUESTS;
+    coap_opt_iterator_t iterator;
+    coap_pdu_t *pdu;
+    uint64_t start;
+    uint64_t parseNs;
+    uint64_t lookupNs;
+    uint found = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                requests = atoi(optarg);
+                break;
+            default:
+                printf("Usage: %s [-n requests]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_ERR);
+
+    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, 0, sizeof(datagram));
+    if(pdu == NULL)
+    {
+        return 1;
+    }
+
+    start = now_ns();
+    for(uint i = 0; i < requests; i++)
+    {
+        coap_pdu_parse(COAP_PROTO_UDP, datagram, length, pdu);
+    }
+    parseNs = now_ns() - start;
+
+    start = now_ns();
+    for(uint i = 0; i < requests; i++)
+    {
+        coap_pdu_parse(COAP_PROTO_UDP, datagram, length, pdu);
+        for(uint j = 0; j < lookupCount; j++)
+        {
+            found += coap_check_option(pdu, lookups[j], &iterator) != NULL;
+        }
+    }
+    lookupNs = now_ns() - start;
+
+    printf("option index: %s\n", OPTION_BENCH_INDEX ? "on" : "off");
+    printf("parse %6.1f ns/request, parse and %u lookups %6.1f ns/request, %5.1f ns/lookup, %u of %u found\n",
+           (double)parseNs / requests, lookupCount, (double)lookupNs / requests,
+           (double)(lookupNs - parseNs) / requests / lookupCount, found / requests, lookupCount);
+
+    coap_delete_pdu(pdu);
+    coap_cleanup();
+
+    return 0;
+}
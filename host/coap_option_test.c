@@ -0,0 +1,291 @@
+/**
+ * @file coap_option_test.c
+ * @brief Host Test of the Option Lookups: every coap_check_option() Result of a parsed PDU has to match a plain Walk
+ * over the Options (first Instance, Number of Instances), for repeated Options, extended Tokens, after
+ * coap_update_token() and after Options were added to the parsed PDU. ctest runs it with ENABLE_OPTION_INDEX OFF and ON
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <coap3/coap.h>
+// coap_update_token(), coap_insert_option() and coap_remove_option() are internal to libcoap
+#include <coap3/coap_internal.h>
+
+// The Variant of ctest has to test the Index, not a Walk again
+#if OPTION_TEST_INDEX && !COAP_OPTION_INDEX
+#error "libcoap is built without the Option Index"
+#endif
+
+#define OPTION_TEST_DATAGRAM 2048
+#define OPTION_TEST_MAX_NUMBER 300  // Checked Option Numbers, beyond the 64 Numbers of the Index
+#define OPTION_TEST_PAYLOAD 64
+
+/**
+ * @brief Option of a Test Request, Numbers in ascending Order
+ *
+ */
+struct test_option{
+    coap_option_num_t number;
+    const char *value;
+};
+typedef struct test_option test_option_t;
+
+// Q-Block1 Request of the Sensor
+static const test_option_t sensorOptions[] = {
+    {COAP_OPTION_URI_PATH, "audio"},
+    {COAP_OPTION_CONTENT_FORMAT, "\x2A"},
+    {COAP_OPTION_Q_BLOCK1, "\x0E"},
+    {COAP_OPTION_SIZE1, "\x13\x88"},
+};
+
+// Repeated Options and Numbers above the Index
+static const test_option_t repeatedOptions[] = {
+    {COAP_OPTION_IF_MATCH, "\x01\x02"},
+    {COAP_OPTION_ETAG, "\x11"},
+    {COAP_OPTION_ETAG, "\x22"},
+    {COAP_OPTION_URI_PATH, "sensor"},
+    {COAP_OPTION_URI_PATH, "3"},
+    {COAP_OPTION_URI_PATH, "audio"},
+    {COAP_OPTION_CONTENT_FORMAT, "\x2A"},
+    {COAP_OPTION_URI_QUERY, "seq=1"},
+    {COAP_OPTION_URI_QUERY, "mode=2"},
+    {COAP_OPTION_SIZE1, "\x13\x88"},
+    {COAP_OPTION_NORESPONSE, "\x02"},
+    {COAP_OPTION_RTAG, "\x05"},
+    {COAP_OPTION_RTAG, ""},
+};
+
+// Token Lengths: plain, 1 Byte and 2 Byte Extension (RFC 8974)
+static const size_t tokenLengths[] = {0, 8, 12, 13, 20, 268, 269, 300};
+
+/**
+ * @brief Encode a NON POST with Token, Options and Payload into a Datagram
+ *
+ * @return Length of the Datagram // 0 if it does not fit
+ */
+static size_t encode_request(uint8_t *datagram, size_t tokenLength, const test_option_t *options, uint optionCount)
+{
+    size_t length = 4;
+    coap_option_num_t previous = 0;
+
+    datagram[1] = COAP_REQUEST_CODE_POST;
+    datagram[2] = 0x12;
+    datagram[3] = 0x34;
+    if(tokenLength < 13)
+    {
+        datagram[0] = 0x50 | tokenLength;
+    }
+    else if(tokenLength < 269)
+    {
+        datagram[0] = 0x50 | 13;
+        datagram[length++] = tokenLength - 13;
+    }
+    else
+    {
+        datagram[0] = 0x50 | 14;
+        datagram[length++] = (tokenLength - 269) >> 8;
+        datagram[length++] = (tokenLength - 269) & 0xFF;
+    }
+    for(size_t i = 0; i < tokenLength; i++)
+    {
+        datagram[length++] = (uint8_t)(i + 1);
+    }
+
+    for(uint i = 0; i < optionCount; i++)
+    {
+        size_t size = coap_opt_encode(datagram + length, OPTION_TEST_DATAGRAM - length, options[i].number - previous,
+                                      (const uint8_t *)options[i].value, strlen(options[i].value));
+
+        if(size == 0)
+        {
+            return 0;
+        }
+        length += size;
+        previous = options[i].number;
+    }
+
+    datagram[length++] = COAP_PAYLOAD_START;
+    memset(datagram + length, 0x55, OPTION_TEST_PAYLOAD);
+
+    return length + OPTION_TEST_PAYLOAD;
+}
+
+/**
+ * @brief Reference: walk all Options, first Instance and Number of Instances of an Option Number
+ *
+ */
+static coap_opt_t *walk_option(const coap_pdu_t *pdu, coap_option_num_t number, uint *count)
+{
+    coap_opt_iterator_t iterator;
+    coap_opt_t *option;
+    coap_opt_t *first = NULL;
+
+    *count = 0;
+    coap_option_iterator_init(pdu, &iterator, COAP_OPT_ALL);
+    while((option = coap_option_next(&iterator)) != NULL)
+    {
+        if(iterator.number == number)
+        {
+            first = (first == NULL) ? option : first;
+            (*count)++;
+        }
+    }
+
+    return first;
+}
+
+/**
+ * @brief Compare coap_check_option() and the Walk for all Option Numbers up to OPTION_TEST_MAX_NUMBER
+ *
+ * @return -1 if a Lookup differs // 1 if all Lookups match
+ */
+static int check_lookups(const coap_pdu_t *pdu, const char *name)
+{
+    coap_opt_iterator_t iterator;
+    coap_opt_t *option;
+    coap_opt_t *expected;
+    uint expectedCount;
+    uint count;
+
+    for(coap_option_num_t number = 0; number <= OPTION_TEST_MAX_NUMBER; number++)
+    {
+        expected = walk_option(pdu, number, &expectedCount);
+        option = coap_check_option(pdu, number, &iterator);
+        count = 0;
+        if(option != NULL)
+        {
+            // The Iterator continues with the next Instance of the same Number
+            for(count = 1; coap_option_next(&iterator) != NULL; count++);
+        }
+        if(option != expected || count != expectedCount)
+        {
+            printf("%s: option %u found %p (%u times), walk %p (%u times)\n", name, number, (void *)option, count,
+                   (void *)expected, expectedCount);
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Parse a Request with the given Token Length and compare the Lookups
+ *
+ * @return -1 if parsing failed or a Lookup differs // 1 if all Lookups match
+ */
+static int test_parse(coap_pdu_t *pdu, size_t tokenLength, const test_option_t *options, uint optionCount,
+                      const char *name)
+{
+    uint8_t datagram[OPTION_TEST_DATAGRAM];
+    size_t length = encode_request(datagram, tokenLength, options, optionCount);
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s, token %zu", name, tokenLength);
+    if(length == 0 || !coap_pdu_parse(COAP_PROTO_UDP, datagram, length, pdu) ||
+       coap_pdu_get_token(pdu).length != tokenLength)
+    {
+        printf("%s: parse failed\n", label);
+        return -1;
+    }
+
+    return check_lookups(pdu, label);
+}
+
+/**
+ * @brief coap_update_token() after the Lookups moves the Options, shorter and longer Tokens
+ *
+ * @return -1 if a Lookup differs // 1 if all Lookups match
+ */
+static int test_update_token(coap_pdu_t *pdu)
+{
+    static const size_t updates[] = {2, 0, 13, 200, 8, 1};
+    uint8_t token[200];
+    char label[64];
+
+    memset(token, 0xA5, sizeof(token));
+    if(test_parse(pdu, 8, repeatedOptions, sizeof(repeatedOptions) / sizeof(repeatedOptions[0]), "update") < 0)
+    {
+        return -1;
+    }
+    for(uint i = 0; i < sizeof(updates) / sizeof(updates[0]); i++)
+    {
+        snprintf(label, sizeof(label), "update to token %zu", updates[i]);
+        if(!coap_update_token(pdu, updates[i], token) || coap_pdu_get_token(pdu).length != updates[i] ||
+           check_lookups(pdu, label) < 0)
+        {
+            printf("%s failed\n", label);
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Options added to a parsed PDU: appended, inserted before and removed
+ *
+ * @return -1 if a Lookup differs // 1 if all Lookups match
+ */
+static int test_modify(coap_pdu_t *pdu)
+{
+    static const uint8_t accept[] = {COAP_MEDIATYPE_APPLICATION_OCTET_STREAM};
+    static const uint8_t observe[] = {0};
+
+    if(test_parse(pdu, 8, sensorOptions, sizeof(sensorOptions) / sizeof(sensorOptions[0]), "modify") < 0)
+    {
+        return -1;
+    }
+    if(!coap_insert_option(pdu, COAP_OPTION_ACCEPT, sizeof(accept), accept) ||
+       check_lookups(pdu, "insert Accept") < 0)
+    {
+        return -1;
+    }
+    if(!coap_insert_option(pdu, COAP_OPTION_OBSERVE, sizeof(observe), observe) ||
+       check_lookups(pdu, "insert Observe") < 0)
+    {
+        return -1;
+    }
+    if(!coap_remove_option(pdu, COAP_OPTION_URI_PATH) || check_lookups(pdu, "remove Uri-Path") < 0)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    coap_pdu_t *pdu;
+    int failed = 0;
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_ERR);
+
+    pdu = coap_pdu_init(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, 0, OPTION_TEST_DATAGRAM);
+    if(pdu == NULL)
+    {
+        return 1;
+    }
+
+    for(uint i = 0; i < sizeof(tokenLengths) / sizeof(tokenLengths[0]); i++)
+    {
+        failed += test_parse(pdu, tokenLengths[i], sensorOptions, sizeof(sensorOptions) / sizeof(sensorOptions[0]),
+                             "sensor") < 0;
+        failed += test_parse(pdu, tokenLengths[i], repeatedOptions,
+                             sizeof(repeatedOptions) / sizeof(repeatedOptions[0]), "repeated") < 0;
+    }
+    failed += test_parse(pdu, 8, NULL, 0, "no options") < 0;
+    failed += test_update_token(pdu) < 0;
+    failed += test_modify(pdu) < 0;
+
+    coap_delete_pdu(pdu);
+    coap_cleanup();
+
+    printf("option index: %s, %s\n", OPTION_TEST_INDEX ? "on" : "off", failed ? "FAILED" : "PASSED");
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file coap_queue_bench.c
+ * @brief Host Benchmark of the libcoap Retransmission Queue: keeps thousands of CON Messages outstanding to a Socket
+ * which never answers and measures the Cost of one more coap_send() (Insert into the Sendqueue) and of the Timeouts
+ * (coap_io_process() pops and reinserts every Message). Compare a Build with ENABLE_SENDQUEUE_HEAP OFF and ON
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <coap3/coap.h>
+
+#define QUEUE_BENCH_BATCH 1000  // Measured Sends on top of the outstanding Messages
+#define QUEUE_BENCH_PAYLOAD 64
+#define QUEUE_BENCH_MAX_SIZES 16
+
+static const uint queueSizes[] = {100, 1000, 2000, 5000, 10000, 20000};
+
+/**
+ * @brief Monotonic Time in ns
+ *
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Send one CON POST, stays in the Sendqueue until all Retransmissions are done
+ *
+ * @return -1 if send failed // 1 if send successfull
+ */
+static int send_con(coap_session_t *session)
+{
+    static const uint8_t payload[QUEUE_BENCH_PAYLOAD];
+    coap_pdu_t *pdu;
+    uint8_t token[8];
+    size_t tokenLength;
+
+    pdu = coap_pdu_init(COAP_MESSAGE_CON, COAP_REQUEST_CODE_POST, coap_new_message_id(session),
+                        coap_session_max_pdu_size(session));
+    if(pdu == NULL)
+    {
+        return -1;
+    }
+    coap_session_new_token(session, &tokenLength, token);
+    coap_add_token(pdu, tokenLength, token);
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 5, (const uint8_t *)"audio");
+    coap_add_data(pdu, sizeof(payload), payload);
+
+    return coap_send(session, pdu) == COAP_INVALID_MID ? -1 : 1;
+}
+
+/**
+ * @brief Fill the Sendqueue with outstanding CON Messages, then time a Batch of Inserts and one Round of Timeouts
+ *
+ * @param address Black Hole, bound but never read
+ * @param outstanding Messages in the Sendqueue before the Batch
+ * @return -1 if a Send failed // 1 if the Line was printed
+ */
+static int run(const coap_address_t *address, uint outstanding)
+{
+    coap_context_t *context = coap_new_context(NULL);
+    coap_session_t *session;
+    coap_fixed_point_t ackTimeout = {1, 0};
+    uint64_t start;
+    uint64_t insertNs;
+    uint64_t timeoutNs;
+
+    if(context == NULL)
+    {
+        return -1;
+    }
+    session = coap_new_client_session(context, NULL, address, COAP_PROTO_UDP);
+    if(session == NULL)
+    {
+        coap_free_context(context);
+        return -1;
+    }
+    // All Messages in flight at once, no Delay Queue
+    coap_session_set_nstart(session, outstanding + QUEUE_BENCH_BATCH);
+    coap_session_set_ack_timeout(session, ackTimeout);
+    coap_session_set_max_retransmit(session, 4);
+
+    for(uint i = 0; i < outstanding; i++)
+    {
+        if(send_con(session) < 0)
+        {
+            coap_free_context(context);
+            return -1;
+        }
+    }
+
+    start = now_ns();
+    for(uint i = 0; i < QUEUE_BENCH_BATCH; i++)
+    {
+        if(send_con(session) < 0)
+        {
+            coap_free_context(context);
+            return -1;
+        }
+    }
+    insertNs = now_ns() - start;
+
+    // First Retransmission of every Message: Pop, Resend, Insert with doubled Timeout
+    usleep(1600 * 1000);
+    start = now_ns();
+    coap_io_process(context, COAP_IO_NO_WAIT);
+    timeoutNs = now_ns() - start;
+
+    printf("%11u %14.2f %17.2f\n", outstanding, (double)insertNs / QUEUE_BENCH_BATCH / 1000,
+           (double)timeoutNs / (outstanding + QUEUE_BENCH_BATCH) / 1000);
+    coap_free_context(context);
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    coap_address_t address;
+    socklen_t length = sizeof(address.addr.sin);
+    uint sizes[QUEUE_BENCH_MAX_SIZES];
+    uint count = 0;
+    int blackHole;
+    int rcvbuf = 4096;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n':
+                if(count < QUEUE_BENCH_MAX_SIZES)
+                {
+                    sizes[count++] = atoi(optarg);
+                }
+                break;
+            default:
+                printf("Usage: %s [-n outstanding messages]...\n", argv[0]);
+                return 1;
+        }
+    }
+    if(count == 0)
+    {
+        count = sizeof(queueSizes) / sizeof(queueSizes[0]);
+        memcpy(sizes, queueSizes, sizeof(queueSizes));
+    }
+
+    // Bound, so no ICMP Port Unreachable cancels the Session, small Buffer, the Datagrams are dropped
+    blackHole = socket(AF_INET, SOCK_DGRAM, 0);
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    setsockopt(blackHole, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if(blackHole < 0 || bind(blackHole, &address.addr.sa, length) < 0 ||
+       getsockname(blackHole, &address.addr.sa, &length) < 0)
+    {
+        printf("Black hole socket failed\n");
+        return 1;
+    }
+    address.size = length;
+
+    coap_startup();
+    coap_set_log_level(COAP_LOG_ERR);
+
+    printf("sendqueue: %s\n", QUEUE_BENCH_HEAP ? "heap" : "list");
+    printf("outstanding  insert us/msg  timeout us/msg\n");
+    for(uint i = 0; i < count; i++)
+    {
+        if(run(&address, sizes[i]) < 0)
+        {
+            printf("%11u failed\n", sizes[i]);
+        }
+    }
+
+    coap_cleanup();
+    close(blackHole);
+
+    return 0;
+}
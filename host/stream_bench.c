@@ -0,0 +1,439 @@
+/**
+ * @file stream_bench.c
+ * @brief Host Benchmark of the UDP and TCP Stream over Loopback with Frames of the Throughput Mode. UDP sends every Frame
+ * once and can drop every n-th Datagram, TCP runs tcp_stream.c and the Resume of send_task_tcp() (unacknowledged Frames
+ * pinned in the arq.c History) against a Receiver which can break the Connection every n Frames. Reports delivered
+ * Frames, Losses, Frames/s and Mbit/s of both Transports
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "arq.h"
+#include "tcp_stream.h"
+
+#define BENCH_UDP_PORT 56850
+#define BENCH_TCP_PORT 56851
+#define BENCH_FRAME_WORDS 2505      // FRAME_SIZE of main.c
+#define BENCH_FRAME_US 55000        // THROUGHPUT_FRAME_US of main.c, Sensor Rate for Comparison
+#define BENCH_FRAMES 2000
+#define BENCH_UNACKED 4             // TCP_UNACKED_FRAMES of main.c
+#define BENCH_RECEIVE_TIMEOUT_MS 200
+#define BENCH_RCVBUF (4 * 1024 * 1024)
+
+/**
+ * @brief Transport of a Run
+ *
+ */
+enum bench_transport{
+    BENCH_UDP,
+    BENCH_TCP,
+};
+typedef enum bench_transport bench_transport_t;
+
+/**
+ * @brief Settings and Counters of one Run, the Receiver Thread owns received, duplicates and lastReceiveUs
+ *
+ */
+struct bench{
+    bench_transport_t transport;
+    uint frames;
+    uint dropEvery;         // UDP: drop every n-th Datagram before sendto(), 0 --> no Loss
+    uint breakEvery;        // TCP: Receiver closes the Connection after n Frames, 0 --> never
+    int listenSock;
+    bool *received;
+    uint receivedCount;
+    uint duplicates;
+    uint breaks;
+    uint dropped;
+    uint resent;
+    int64_t firstSendUs;
+    int64_t lastReceiveUs;
+    volatile bool senderDone;
+};
+typedef struct bench bench_t;
+
+static const char *transport_names[] = {"udp", "tcp"};
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((int64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+}
+
+/**
+ * @brief Count a received Sequence Number
+ *
+ */
+static void receive_seq(bench_t *bench, uint32_t seq)
+{
+    if(seq >= bench->frames)
+    {
+        return;
+    }
+    if(bench->received[seq])
+    {
+        bench->duplicates++;
+        return;
+    }
+    bench->received[seq] = true;
+    bench->receivedCount++;
+    bench->lastReceiveUs = esp_timer_get_time();
+}
+
+/**
+ * @brief Read exactly length Bytes from a TCP Socket
+ *
+ * @return -1 if the Connection was closed // 1 if complete
+ */
+static int read_all(int sock, void *buffer, size_t length)
+{
+    size_t done = 0;
+    ssize_t err;
+
+    while(done < length)
+    {
+        err = recv(sock, (uint8_t *)buffer + done, length - done, 0);
+        if(err <= 0)
+        {
+            return -1;
+        }
+        done += err;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief UDP Receiver: counts Frames until the Sender is done and nothing arrives for BENCH_RECEIVE_TIMEOUT_MS
+ *
+ */
+static void *udp_receiver(void *arg)
+{
+    bench_t *bench = arg;
+    static uint32_t frame[BENCH_FRAME_WORDS];
+    struct timeval timeout = {0, BENCH_RECEIVE_TIMEOUT_MS * 1000};
+    ssize_t length;
+
+    setsockopt(bench->listenSock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while(1)
+    {
+        length = recv(bench->listenSock, frame, sizeof(frame), 0);
+        if(length < 0)
+        {
+            if(bench->senderDone)
+            {
+                break;
+            }
+            continue;
+        }
+        if(length >= (ssize_t)sizeof(uint32_t))
+        {
+            receive_seq(bench, ntohl(frame[0]));
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief TCP Receiver like the Server: reads length-prefixed Frames and acknowledges each with its Sequence Number.
+ * Breaks the Connection every breakEvery Frames, unread Frames in the Socket are lost and have to be resumed
+ *
+ */
+static void *tcp_receiver(void *arg)
+{
+    bench_t *bench = arg;
+    static uint32_t frame[BENCH_FRAME_WORDS];
+    uint32_t length;
+    uint32_t ack;
+    uint count;
+    int sock;
+
+    while(!bench->senderDone || bench->receivedCount < bench->frames)
+    {
+        sock = accept(bench->listenSock, NULL, NULL);
+        if(sock < 0)
+        {
+            break;
+        }
+        count = 0;
+        while(read_all(sock, &length, sizeof(length)) > 0)
+        {
+            length = ntohl(length);
+            if(length < sizeof(uint32_t) || length > sizeof(frame) || read_all(sock, frame, length) < 0)
+            {
+                break;
+            }
+            receive_seq(bench, ntohl(frame[0]));
+            ack = frame[0];
+            if(send(sock, &ack, sizeof(ack), MSG_NOSIGNAL) < 0)
+            {
+                break;
+            }
+            count++;
+            if(bench->breakEvery > 0 && count == bench->breakEvery)
+            {
+                bench->breaks++;
+                break;
+            }
+        }
+        close(sock);
+        if(bench->receivedCount == bench->frames)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Send every Frame once with sendto(), dropping every dropEvery-th Datagram
+ *
+ */
+static void udp_sender(bench_t *bench, frame_t *frames, const struct sockaddr_in *addr)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    for(uint i = 0; i < bench->frames; i++)
+    {
+        if(bench->dropEvery > 0 && i % bench->dropEvery == bench->dropEvery - 1)
+        {
+            bench->dropped++;
+            continue;
+        }
+        // Blocking Socket: Loopback only drops if the Receiver Buffer overflows
+        sendto(sock, frames[i].data, frames[i].length * sizeof(uint32_t), 0, (const struct sockaddr *)addr, sizeof(*addr));
+    }
+    close(sock);
+}
+
+/**
+ * @brief Send-Loop of send_task_tcp(): at most BENCH_UNACKED Frames in flight, acknowledged Frames leave the History and
+ * after a Reconnect the unacknowledged Frames are send again
+ *
+ */
+static void tcp_sender(bench_t *bench, frame_t *frames, const struct sockaddr_in *addr)
+{
+    tcp_stream_t *stream = init_tcp_stream(addr);
+    arq_handle_t *arq = init_arq(BENCH_UNACKED, 0, 0);
+    frame_t *resume[BENCH_UNACKED];
+    struct pollfd wait;
+    uint next = 0;
+    uint count;
+
+    while(stream->lastAcked + 1 != bench->frames)
+    {
+        if(stream->sock < 0)
+        {
+            if(tcp_stream_connect(stream) < 0)
+            {
+                usleep(1000);
+                continue;
+            }
+            count = arq_history_after(arq, stream->lastAcked, resume);
+            for(uint i = 0; i < count; i++)
+            {
+                if(tcp_stream_send_frame(stream, resume[i]) < 0)
+                {
+                    tcp_stream_close(stream);
+                    break;
+                }
+                bench->resent++;
+            }
+            continue;
+        }
+
+        if(arq->historyCount < BENCH_UNACKED && next < bench->frames)
+        {
+            if(tcp_stream_send_frame(stream, &frames[next]) < 0)
+            {
+                tcp_stream_close(stream);
+            }
+            arq_store_frame(arq, &frames[next]);
+            next++;
+        }
+        else
+        {
+            // Window full: wait for the next Ack instead of the Tick of send_task_tcp()
+            wait.fd = stream->sock;
+            wait.events = POLLIN;
+            poll(&wait, 1, 1);
+        }
+
+        if(stream->sock >= 0 && tcp_stream_poll_ack(stream) < 0)
+        {
+            tcp_stream_close(stream);
+        }
+        while(arq_pop_acked(arq, stream->lastAcked) != NULL);
+    }
+    tcp_stream_close(stream);
+    vQueueDelete(arq->requestQueue);
+    free(arq->history);
+    free(arq);
+    free(stream);
+}
+
+/**
+ * @brief Run one Transport and print its Counters
+ *
+ * @return -1 if the Receiver could not be started or TCP lost a Frame // 1 else
+ */
+static int run_bench(bench_t *bench, frame_t *frames)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(bench->transport == BENCH_UDP ? BENCH_UDP_PORT : BENCH_TCP_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int option = 1;
+    int size = BENCH_RCVBUF;
+    pthread_t receiver;
+    double seconds;
+
+    bench->received = calloc(bench->frames, sizeof(bool));
+    bench->listenSock = socket(AF_INET, bench->transport == BENCH_UDP ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if(bench->received == NULL || bench->listenSock < 0)
+    {
+        free(bench->received);
+        return -1;
+    }
+    setsockopt(bench->listenSock, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    setsockopt(bench->listenSock, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    if(bind(bench->listenSock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+       (bench->transport == BENCH_TCP && listen(bench->listenSock, 1) < 0))
+    {
+        printf("%s: port %u in use\n", transport_names[bench->transport], ntohs(addr.sin_port));
+        close(bench->listenSock);
+        free(bench->received);
+        return -1;
+    }
+
+    pthread_create(&receiver, NULL, bench->transport == BENCH_UDP ? udp_receiver : tcp_receiver, bench);
+    bench->firstSendUs = esp_timer_get_time();
+    if(bench->transport == BENCH_UDP)
+    {
+        udp_sender(bench, frames, &addr);
+    }
+    else
+    {
+        tcp_sender(bench, frames, &addr);
+    }
+    bench->senderDone = true;
+    pthread_join(receiver, NULL);
+    close(bench->listenSock);
+
+    seconds = (bench->lastReceiveUs - bench->firstSendUs) / 1e6;
+    if(seconds <= 0)
+    {
+        seconds = 1e-6;
+    }
+    printf("%s: %u frames, %u received, %u lost (%u dropped by -l), %u duplicates, %u breaks, %u resent, "
+           "%.0f frames/s (%.0fx sensor), %.1f Mbit/s\n",
+           transport_names[bench->transport], bench->frames, bench->receivedCount, bench->frames - bench->receivedCount,
+           bench->dropped, bench->duplicates, bench->breaks, bench->resent, bench->receivedCount / seconds,
+           (bench->receivedCount / seconds) / (1e6 / BENCH_FRAME_US),
+           (bench->receivedCount * (double)BENCH_FRAME_WORDS * 32) / seconds / 1e6);
+    free(bench->received);
+
+    // The Resume must deliver every Frame, however often the Connection breaks
+    return (bench->transport == BENCH_TCP && bench->receivedCount != bench->frames) ? -1 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    frame_t *frames;
+    bench_t bench;
+    int transport = -1;
+    uint count = BENCH_FRAMES;
+    uint dropEvery = 0;
+    uint breakEvery = 0;
+    int failed = 0;
+    int opt;
+
+    while((opt = getopt(argc, argv, "t:n:l:r:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 't':
+                transport = (strcmp(optarg, "udp") == 0) ? BENCH_UDP : (strcmp(optarg, "tcp") == 0) ? BENCH_TCP : -2;
+                break;
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'l':
+                dropEvery = atoi(optarg);
+                break;
+            case 'r':
+                breakEvery = atoi(optarg);
+                break;
+            default:
+                transport = -2;
+                break;
+        }
+    }
+    if(transport == -2 || count == 0)
+    {
+        printf("Usage: %s [-t udp|tcp] [-n frames] [-l drop every n-th UDP datagram] [-r break TCP every n frames]\n",
+               argv[0]);
+        printf("Without -t both Transports are run\n");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Frames of the Throughput Mode, Sequence Number in the first Word
+    frames = calloc(count, sizeof(frame_t));
+    for(uint i = 0; i < count && frames != NULL; i++)
+    {
+        frames[i].data = calloc(BENCH_FRAME_WORDS, sizeof(uint32_t));
+        if(frames[i].data == NULL)
+        {
+            return 1;
+        }
+        frames[i].seq = i;
+        frames[i].length = BENCH_FRAME_WORDS;
+        frames[i].size = BENCH_FRAME_WORDS;
+        frames[i].data[0] = htonl(i);
+    }
+    if(frames == NULL)
+    {
+        return 1;
+    }
+
+    for(int t = BENCH_UDP; t <= BENCH_TCP; t++)
+    {
+        if(transport >= 0 && t != transport)
+        {
+            continue;
+        }
+        memset(&bench, 0, sizeof(bench));
+        bench.transport = t;
+        bench.frames = count;
+        bench.dropEvery = dropEvery;
+        bench.breakEvery = breakEvery;
+        failed += run_bench(&bench, frames) < 0;
+    }
+
+    for(uint i = 0; i < count; i++)
+    {
+        free(frames[i].data);
+    }
+    free(frames);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+/**
+ * @file esp_log.h
+ * @brief Host Stub of the ESP Log: Errors go to stderr, Info is dropped so Benchmarks are not slowed down by Output
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_ESP_LOG_H__
+#define __STUB_ESP_LOG_H__
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do {} while(0)
+
+#endif
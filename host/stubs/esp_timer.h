@@ -0,0 +1,20 @@
+/**
+ * @file esp_timer.h
+ * @brief Host Stub of the ESP Timer, the Test provides the Clock
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_ESP_TIMER_H__
+#define __STUB_ESP_TIMER_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Time in us since Start, implemented by the Test
+ *
+ */
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,25 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host Stub of the FreeRTOS Types used by the Sensor Modules under Test
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_FREERTOS_H__
+#define __STUB_FREERTOS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portTICK_PERIOD_MS 1
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file queue.h
+ * @brief Host Stub of the FreeRTOS Queue: single-threaded FIFO of fixed-size Items, Ticks to wait are ignored
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_QUEUE_H__
+#define __STUB_QUEUE_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+struct stub_queue{
+    uint8_t *items;
+    size_t itemSize;
+    size_t length;
+    size_t head;
+    size_t count;
+};
+typedef struct stub_queue *QueueHandle_t;
+
+static inline QueueHandle_t xQueueCreate(size_t length, size_t itemSize)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct stub_queue));
+
+    if(queue == NULL)
+    {
+        return NULL;
+    }
+    queue->items = calloc(length, itemSize);
+    if(queue->items == NULL)
+    {
+        free(queue);
+        return NULL;
+    }
+    queue->itemSize = itemSize;
+    queue->length = length;
+
+    return queue;
+}
+
+static inline void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->items);
+    free(queue);
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    if(queue->count == queue->length)
+    {
+        return pdFALSE;
+    }
+    memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    if(queue->count == 0)
+    {
+        return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+
+    return pdTRUE;
+}
+
+static inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+#endif
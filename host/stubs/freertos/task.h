@@ -0,0 +1,16 @@
+/**
+ * @file task.h
+ * @brief Host Stub of the FreeRTOS Task Handle
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_TASK_H__
+#define __STUB_TASK_H__
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file sockets.h
+ * @brief Host Stub of the lwIP Socket Header, maps to the POSIX Sockets
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __STUB_LWIP_SOCKETS_H__
+#define __STUB_LWIP_SOCKETS_H__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#endif
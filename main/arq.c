@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "arq.h"
+
+// Defines
+#define ARQ_REQUEST_QUEUE_SIZE 16
+
+/**
+ * @brief Search the History for a Sequence Number
+ *
+ * @param arq Pointer to Retransmission State
+ * @param seq Sequence Number
+ * @return frame_t* Frame with seq // NULL if not in History
+ */
+static frame_t *find_frame(arq_handle_t *arq, uint32_t seq)
+{
+    for(uint i = 0; i < arq->historyCount; i++)
+    {
+        frame_t *frame = arq->history[(arq->historyTail + i) % arq->historySize];
+        if(frame->seq == seq)
+        {
+            return frame;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Refill Token Bucket with the Time elapsed since last Refill
+ *
+ * @param arq Pointer to Retransmission State
+ */
+static void refill_tokens(arq_handle_t *arq)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t add = (uint32_t)(((now - arq->lastRefill) * arq->rate) / 1000000);
+
+    if(add > 0)
+    {
+        arq->tokens = (arq->tokens + add > arq->burst) ? arq->burst : arq->tokens + add;
+        arq->lastRefill = now;
+    }
+}
+
+arq_handle_t *init_arq(uint historySize, uint rate, uint burst)
+{
+    arq_handle_t *arq;
+
+    arq = calloc(1, sizeof(arq_handle_t));
+    if(arq == NULL)
+    {
+        return NULL;
+    }
+
+    arq->history = calloc(historySize, sizeof(frame_t *));
+    if(arq->history == NULL)
+    {
+        free(arq);
+        return NULL;
+    }
+
+    arq->requestQueue = xQueueCreate(ARQ_REQUEST_QUEUE_SIZE, sizeof(arq_range_t));
+    if(arq->requestQueue == NULL)
+    {
+        free(arq->history);
+        free(arq);
+        return NULL;
+    }
+
+    arq->historySize = historySize;
+    arq->rate = rate;
+    arq->burst = burst;
+    arq->tokens = burst;
+    arq->lastRefill = esp_timer_get_time();
+
+    return arq;
+}
+
+frame_t *arq_store_frame(arq_handle_t *arq, frame_t *frame)
+{
+    frame_t *evicted = NULL;
+
+    if(arq->historySize == 0)
+    {
+        return frame;
+    }
+
+    if(arq->historyCount == arq->historySize)
+    {
+        evicted = arq->history[arq->historyTail];
+        arq->historyTail = (arq->historyTail + 1) % arq->historySize;
+        arq->historyCount--;
+    }
+
+    arq->history[(arq->historyTail + arq->historyCount) % arq->historySize] = frame;
+    arq->historyCount++;
+
+    return evicted;
+}
+
+int arq_parse_nack(arq_handle_t *arq, const uint8_t *message, size_t length, struct in_addr requester)
+{
+    arq_range_t range;
+    uint32_t value;
+    int queued = 0;
+
+    if(length == 0 || length % (2 * sizeof(uint32_t)) != 0)
+    {
+        return -1;
+    }
+
+    arq->stats.nacks++;
+    range.requester = requester;
+    for(size_t i = 0; i < length; i += 2 * sizeof(uint32_t))
+    {
+        memcpy(&value, &message[i], sizeof(value));
+        range.first = ntohl(value);
+        memcpy(&value, &message[i + sizeof(uint32_t)], sizeof(value));
+        range.last = ntohl(value);
+
+        if((int32_t)(range.last - range.first) < 0)
+        {
+            continue;
+        }
+
+        if(xQueueSend(arq->requestQueue, &range, 0) == pdTRUE)
+        {
+            queued++;
+        }
+        else
+        {
+            arq->stats.overflow++;
+        }
+    }
+
+    return queued;
+}
+
+frame_t *arq_next_retransmission(arq_handle_t *arq, struct in_addr *requester)
+{
+    frame_t *frame;
+    uint32_t oldest;
+    uint32_t newest;
+
+    refill_tokens(arq);
+
+    while(1)
+    {
+        if(!arq->active)
+        {
+            if(xQueueReceive(arq->requestQueue, &arq->current, 0) != pdTRUE)
+            {
+                return NULL;
+            }
+            arq->active = true;
+        }
+
+        if(arq->historyCount == 0)
+        {
+            arq->stats.notInHistory += arq->current.last - arq->current.first + 1;
+            arq->active = false;
+            continue;
+        }
+
+        // Skip everything older than the History, so a bogus Range costs at most historySize Lookups
+        oldest = arq->history[arq->historyTail]->seq;
+        newest = arq->history[(arq->historyTail + arq->historyCount - 1) % arq->historySize]->seq;
+        if((int32_t)(arq->current.first - oldest) < 0)
+        {
+            uint32_t skip = ((int32_t)(arq->current.last - oldest) < 0) ? arq->current.last - arq->current.first + 1 : oldest - arq->current.first;
+            arq->stats.notInHistory += skip;
+            arq->current.first += skip;
+        }
+
+        while((int32_t)(arq->current.last - arq->current.first) >= 0 && (int32_t)(newest - arq->current.first) >= 0)
+        {
+            if(arq->tokens == 0)
+            {
+                arq->stats.rateLimited++;
+                return NULL;
+            }
+
+            frame = find_frame(arq, arq->current.first);
+            arq->current.first++;
+            if(frame != NULL)
+            {
+                arq->tokens--;
+                arq->stats.retransmitted++;
+                *requester = arq->current.requester;
+                return frame;
+            }
+            arq->stats.notInHistory++;
+        }
+
+        arq->active = false;
+    }
+}
+
+bool arq_has_requests(arq_handle_t *arq)
+{
+    return arq->active || uxQueueMessagesWaiting(arq->requestQueue) > 0;
+}
+
+frame_t *arq_pop_acked(arq_handle_t *arq, uint32_t seq)
+{
+    frame_t *frame;
+
+    if(arq->historyCount == 0)
+    {
+        return NULL;
+    }
+
+    frame = arq->history[arq->historyTail];
+    if((int32_t)(frame->seq - seq) > 0)
+    {
+        return NULL;
+    }
+    arq->historyTail = (arq->historyTail + 1) % arq->historySize;
+    arq->historyCount--;
+
+    return frame;
+}
+
+uint arq_history_after(arq_handle_t *arq, uint32_t seq, frame_t **frames)
+{
+    uint count = 0;
+
+    for(uint i = 0; i < arq->historyCount; i++)
+    {
+        frame_t *frame = arq->history[(arq->historyTail + i) % arq->historySize];
+        if((int32_t)(frame->seq - seq) > 0)
+        {
+            frames[count] = frame;
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+// Custom Headerfiles
+#include "bitrate.h"
+
+static const char *tag_bitrate = "Bitrate";
+
+// Profiles from full Fidelity to lowest Bitrate, each step halves the Payload
+static const bitrate_profile_t profiles[] = {
+    {.decimation = 1, .sampleBits = 32},
+    {.decimation = 1, .sampleBits = 16},
+    {.decimation = 2, .sampleBits = 16},
+    {.decimation = 4, .sampleBits = 16},
+};
+#define BITRATE_PROFILE_COUNT (sizeof(profiles) / sizeof(profiles[0]))
+
+bitrate_handle_t *init_bitrate(uint32_t fullKbps)
+{
+    bitrate_handle_t *bitrate;
+
+    bitrate = calloc(1, sizeof(bitrate_handle_t));
+    if(bitrate == NULL)
+    {
+        return NULL;
+    }
+
+    bitrate->fullKbps = fullKbps;
+
+    return bitrate;
+}
+
+int bitrate_feedback(bitrate_handle_t *bitrate, uint16_t lossPermille, uint32_t jitterUs, uint32_t throughputKbps)
+{
+    bool congested;
+
+    bitrate->stats.reports++;
+    bitrate->stats.lossPermille = lossPermille;
+    bitrate->stats.jitterUs = jitterUs;
+    bitrate->stats.throughputKbps = throughputKbps;
+
+    congested = lossPermille > BITRATE_LOSS_HIGH || jitterUs > BITRATE_JITTER_HIGH ||
+                (uint64_t)throughputKbps * 100 < (uint64_t)bitrate_kbps(bitrate) * BITRATE_THROUGHPUT_MIN;
+
+    if(congested)
+    {
+        bitrate->cleanReports = 0;
+        if(bitrate->profile + 1 < BITRATE_PROFILE_COUNT)
+        {
+            bitrate->profile++;
+            bitrate->stats.stepsDown++;
+            ESP_LOGI(tag_bitrate, "Profile %u (%lu kbit/s), loss %u, jitter %lu us, throughput %lu kbit/s",
+                     bitrate->profile, bitrate_kbps(bitrate), lossPermille, jitterUs, throughputKbps);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Hysteresis: only clean Reports count towards the next higher Profile
+    if(lossPermille > BITRATE_LOSS_LOW)
+    {
+        bitrate->cleanReports = 0;
+        return 0;
+    }
+
+    bitrate->cleanReports++;
+    if(bitrate->cleanReports >= BITRATE_UP_REPORTS && bitrate->profile > 0)
+    {
+        bitrate->cleanReports = 0;
+        bitrate->profile--;
+        bitrate->stats.stepsUp++;
+        ESP_LOGI(tag_bitrate, "Profile %u (%lu kbit/s)", bitrate->profile, bitrate_kbps(bitrate));
+        return 1;
+    }
+
+    return 0;
+}
+
+int bitrate_set_profile(bitrate_handle_t *bitrate, uint8_t decimation, uint8_t sampleBits)
+{
+    for(uint i = 0; i < BITRATE_PROFILE_COUNT; i++)
+    {
+        if(profiles[i].decimation == decimation && profiles[i].sampleBits == sampleBits)
+        {
+            bitrate->profile = i;
+            bitrate->cleanReports = 0;
+            ESP_LOGI(tag_bitrate, "Profile %u (%lu kbit/s) set", bitrate->profile, bitrate_kbps(bitrate));
+            return 1;
+        }
+    }
+
+    return -1;
+}
+
+const bitrate_profile_t *bitrate_profile(bitrate_handle_t *bitrate)
+{
+    return &profiles[bitrate->profile];
+}
+
+uint32_t bitrate_kbps(bitrate_handle_t *bitrate)
+{
+    const bitrate_profile_t *profile = bitrate_profile(bitrate);
+
+    return (bitrate->fullKbps * profile->sampleBits) / (32 * profile->decimation);
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "coap3/coap.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "coap_audio.h"
+
+static const char *tag_coap_audio = "CoAP-Observe";
+
+/**
+ * @brief Called by libcoap when the Notification (or all Block2 Blocks of it) of one Observer is done. Drops the
+ * Reference of this Observer
+ *
+ * @param session Session of the Observer
+ * @param app_ptr Frame
+ */
+static void release_audio_frame(coap_session_t *session, void *app_ptr)
+{
+    coap_audio_t *audio = coap_session_get_app_data(session);
+
+    release_frame(audio->pool, (frame_t *)app_ptr);
+    audio->stats.released++;
+}
+
+/**
+ * @brief GET Handler of /audio. Called by libcoap for a Request of a Client and once per Observer for every published
+ * Frame. All Observers reference the Data of the same Frame
+ *
+ */
+static void audio_get_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                              const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_audio_t *audio = coap_resource_get_userdata(resource);
+    frame_t *frame = audio->frame;
+
+    // Server Sessions are created by libcoap, the release Callback finds the Resource through the Session
+    coap_session_set_app_data(session, audio);
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    audio->stats.representations++;
+
+    // No Frame yet: empty Representation, the Observe Registration stays
+    if (frame == NULL)
+    {
+        return;
+    }
+
+    audio->observers++;
+    hold_frame(frame);
+    coap_add_data_large_response(resource, session, request, response, query, COAP_MEDIATYPE_APPLICATION_OCTET_STREAM,
+                                 -1, 0, frame->length * sizeof(uint32_t), (const uint8_t *)frame->data,
+                                 release_audio_frame, frame);
+}
+
+coap_audio_t *init_coap_audio(frame_pool_handle_t *pool, uint16_t port, int notifyFd)
+{
+    coap_audio_t *audio;
+    coap_address_t address;
+
+    audio = calloc(1, sizeof(coap_audio_t));
+    if(audio == NULL)
+    {
+        return NULL;
+    }
+
+    coap_startup();
+
+    audio->context = coap_new_context(NULL);
+    if(audio->context == NULL)
+    {
+        free(audio);
+        return NULL;
+    }
+
+    // Frames larger than the MTU are split by libcoap into Block2 (Q-Block2 if the Client asks for it)
+    coap_context_set_block_mode(audio->context, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY);
+
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_port = htons(port);
+    address.addr.sin.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(coap_new_endpoint(audio->context, &address, COAP_PROTO_UDP) == NULL)
+    {
+        ESP_LOGE(tag_coap_audio, "Failed to create CoAP Endpoint on port %u!", port);
+        coap_free_context(audio->context);
+        free(audio);
+        return NULL;
+    }
+
+    audio->resource = coap_resource_init(coap_make_str_const(COAP_AUDIO_PATH), 0);
+    if(audio->resource == NULL)
+    {
+        coap_free_context(audio->context);
+        free(audio);
+        return NULL;
+    }
+    coap_resource_set_userdata(audio->resource, audio);
+    coap_register_request_handler(audio->resource, COAP_REQUEST_GET, audio_get_handler);
+    coap_resource_set_get_observable(audio->resource, 1);
+    // NON Notifications, libcoap sends every COAP_OBS_MAX_NON-th one as CON and removes Observers which do not answer
+    coap_resource_set_mode(audio->resource, COAP_RESOURCE_FLAGS_NOTIFY_NON);
+    coap_add_attr(audio->resource, coap_make_str_const("obs"), NULL, 0);
+    coap_add_resource(audio->context, audio->resource);
+
+    audio->pool = pool;
+    audio->notifyFd = notifyFd;
+
+    ESP_LOGI(tag_coap_audio, "Observe Resource /%s on port %u", COAP_AUDIO_PATH, port);
+
+    return audio;
+}
+
+int coap_audio_publish(coap_audio_t *audio, frame_t *frame)
+{
+    // Observers which still wait for Blocks of the previous Frame keep their own Reference
+    if (audio->frame != NULL)
+    {
+        release_frame(audio->pool, audio->frame);
+    }
+    hold_frame(frame);
+    audio->frame = frame;
+    audio->observers = 0;
+    audio->stats.published++;
+
+    if (!coap_resource_notify_observers(audio->resource, NULL))
+    {
+        audio->stats.unobserved++;
+        return 0;
+    }
+
+    return 1;
+}
+
+void coap_audio_process(coap_audio_t *audio, uint32_t timeout_ms)
+{
+    fd_set readfds;
+    uint64_t events;
+
+    if(audio->notifyFd < 0)
+    {
+        coap_io_process(audio->context, timeout_ms);
+        return;
+    }
+
+    // One select() over the libcoap Socket and the Frame eventfd
+    FD_ZERO(&readfds);
+    FD_SET(audio->notifyFd, &readfds);
+    coap_io_process_with_fds(audio->context, timeout_ms, audio->notifyFd + 1, &readfds, NULL, NULL);
+    if(FD_ISSET(audio->notifyFd, &readfds))
+    {
+        read(audio->notifyFd, &events, sizeof(events));
+    }
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "coap3/coap.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "bitrate.h"
+#include "coap_control.h"
+
+static const char *tag_coap_control = "CoAP-Control";
+
+/**
+ * @brief Copy the Text Payload of request into value, terminated with '\0'
+ *
+ * @param request PUT/POST Request
+ * @param value Buffer with COAP_CONTROL_VALUE_SIZE Bytes
+ * @return -1 if there is no Payload or it is too long // 1 if value is valid
+ */
+static int get_value(const coap_pdu_t *request, char *value)
+{
+    size_t length;
+    const uint8_t *data;
+
+    if(!coap_get_data(request, &length, &data) || length == 0 || length >= COAP_CONTROL_VALUE_SIZE)
+    {
+        return -1;
+    }
+    memcpy(value, data, length);
+    value[length] = '\0';
+
+    return 1;
+}
+
+/**
+ * @brief Answer with a Text Representation
+ *
+ */
+static void send_text(coap_pdu_t *response, const char *text)
+{
+    uint8_t format[4];
+
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    coap_add_option(response, COAP_OPTION_CONTENT_FORMAT,
+                    coap_encode_var_safe(format, sizeof(format), COAP_MEDIATYPE_TEXT_PLAIN), format);
+    coap_add_data(response, strlen(text), (const uint8_t *)text);
+}
+
+/**
+ * @brief Select the Profile with decimation and sampleBits. Answers 2.04 also if the Profile is already set, so repeated
+ * Requests give the same Result
+ *
+ */
+static void set_profile(coap_control_t *control, uint8_t decimation, uint8_t sampleBits, coap_pdu_t *response)
+{
+    const bitrate_profile_t *profile = bitrate_profile(control->bitrate);
+
+    if(profile->decimation == decimation && profile->sampleBits == sampleBits)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+        return;
+    }
+
+    if(bitrate_set_profile(control->bitrate, decimation, sampleBits) < 0)
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        coap_add_data(response, strlen("No Profile"), (const uint8_t *)"No Profile");
+        return;
+    }
+
+    control->counters.changed++;
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+    coap_resource_notify_observers(control->stats, NULL);
+}
+
+/**
+ * @brief GET /config/rate: Sample Rate in Hz of the current Profile
+ *
+ */
+static void rate_get_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                             const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+    char text[COAP_CONTROL_VALUE_SIZE];
+
+    control->counters.requests++;
+    snprintf(text, sizeof(text), "%lu", control->sensorRate / bitrate_profile(control->bitrate)->decimation);
+    send_text(response, text);
+}
+
+/**
+ * @brief PUT /config/rate: Sample Rate in Hz, has to be sensorRate / decimation (as GET reports it) of a Profile with the
+ * current Codec
+ *
+ */
+static void rate_put_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                             const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+    char value[COAP_CONTROL_VALUE_SIZE];
+    char *end;
+    unsigned long rate;
+
+    control->counters.requests++;
+    if(get_value(request, value) < 0)
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    rate = strtoul(value, &end, 10);
+    // sensorRate is not always a Multiple of the Rates, accept the truncated Rate of GET
+    if(*end != '\0' || rate == 0 || rate > control->sensorRate || control->sensorRate / rate > UINT8_MAX
+       || control->sensorRate / (control->sensorRate / rate) != rate)
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    set_profile(control, control->sensorRate / rate, bitrate_profile(control->bitrate)->sampleBits, response);
+}
+
+/**
+ * @brief GET /config/codec: "pcm32" or "pcm16"
+ *
+ */
+static void codec_get_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                              const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+
+    control->counters.requests++;
+    send_text(response, bitrate_profile(control->bitrate)->sampleBits == 16 ? "pcm16" : "pcm32");
+}
+
+/**
+ * @brief PUT /config/codec: "pcm32" or "pcm16" with the current Rate
+ *
+ */
+static void codec_put_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                              const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+    char value[COAP_CONTROL_VALUE_SIZE];
+    uint8_t sampleBits;
+
+    control->counters.requests++;
+    if(get_value(request, value) < 0)
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    if(strcmp(value, "pcm32") == 0)
+    {
+        sampleBits = 32;
+    }
+    else if(strcmp(value, "pcm16") == 0)
+    {
+        sampleBits = 16;
+    }
+    else
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    set_profile(control, bitrate_profile(control->bitrate)->decimation, sampleBits, response);
+}
+
+/**
+ * @brief PUT/POST /control/start: start the Measurement. A running Measurement stays running, so Retransmissions and
+ * repeated Requests are harmless
+ *
+ */
+static void start_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                          const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+
+    control->counters.requests++;
+    control->start();
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+}
+
+/**
+ * @brief PUT /config/enroll: "<SensorID> <Data-Port>" from the Collector, which becomes the Server. Only unicast, every
+ * Sensor needs its own SensorID
+ *
+ */
+static void enroll_put_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                               const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+    const coap_address_t *remote = coap_session_get_addr_remote(session);
+    struct sockaddr_in server;
+    char value[COAP_CONTROL_VALUE_SIZE];
+    unsigned int sensorID;
+    unsigned int port;
+    char end;
+
+    control->counters.requests++;
+    if(coap_is_mcast(coap_session_get_addr_local(session)) || remote->addr.sa.sa_family != AF_INET
+       || get_value(request, value) < 0 || sscanf(value, "%u %u%c", &sensorID, &port, &end) != 2
+       || sensorID > UINT8_MAX || port == 0 || port > UINT16_MAX)
+    {
+        control->counters.rejected++;
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_addr = remote->addr.sin.sin_addr;
+    server.sin_port = htons(port);
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+
+    // Retransmitted or repeated Enrollment
+    if(control->counters.enrollments > 0 && control->sensorID == sensorID && control->server.sin_port == server.sin_port
+       && control->server.sin_addr.s_addr == server.sin_addr.s_addr)
+    {
+        return;
+    }
+
+    control->sensorID = sensorID;
+    control->server = server;
+    control->counters.enrollments++;
+    control->enroll(sensorID, &server);
+}
+
+/**
+ * @brief GET /stats: Counters of Frame Pool, Bitrate Controller and Control Resources as Text, observable
+ *
+ */
+static void stats_get_handler(coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request,
+                              const coap_string_t *query, coap_pdu_t *response)
+{
+    coap_control_t *control = coap_resource_get_userdata(resource);
+    frame_pool_stats_t *pool = &control->pool->stats;
+    char text[256];
+
+    control->counters.requests++;
+    snprintf(text, sizeof(text),
+             "captured=%lu\nsent=%lu\nbytes=%llu\ndropped=%lu\nfailed=%lu\nretries=%lu\nprofile=%u\nkbps=%lu\n"
+             "loss=%u\njitter=%lu\nrequests=%lu\nchanged=%lu\nrejected=%lu\nenrollments=%lu\n",
+             atomic_load(&pool->captured), atomic_load(&pool->sent), atomic_load(&pool->bytesSent),
+             atomic_load(&pool->droppedOldest) + atomic_load(&pool->droppedNewest), atomic_load(&pool->sendFailed),
+             atomic_load(&pool->sendRetries), control->bitrate->profile, bitrate_kbps(control->bitrate),
+             control->bitrate->stats.lossPermille, control->bitrate->stats.jitterUs, control->counters.requests,
+             control->counters.changed, control->counters.rejected, control->counters.enrollments);
+    send_text(response, text);
+}
+
+/**
+ * @brief Create a Resource on path with userdata control
+ *
+ */
+static coap_resource_t *add_resource(coap_control_t *control, const char *path)
+{
+    coap_resource_t *resource = coap_resource_init(coap_make_str_const(path), 0);
+
+    if(resource != NULL)
+    {
+        coap_resource_set_userdata(resource, control);
+        coap_add_resource(control->context, resource);
+    }
+
+    return resource;
+}
+
+coap_control_t *init_coap_control(uint16_t port, frame_pool_handle_t *pool, bitrate_handle_t *bitrate,
+                                  uint32_t sensorRate, void (*start)(void))
+{
+    coap_control_t *control;
+    coap_address_t address;
+    coap_resource_t *rate;
+    coap_resource_t *codec;
+    coap_resource_t *measurement;
+
+    control = calloc(1, sizeof(coap_control_t));
+    if(control == NULL)
+    {
+        return NULL;
+    }
+
+    coap_startup();
+
+    control->context = coap_new_context(NULL);
+    if(control->context == NULL)
+    {
+        free(control);
+        return NULL;
+    }
+
+    coap_address_init(&address);
+    address.addr.sin.sin_family = AF_INET;
+    address.addr.sin.sin_port = htons(port);
+    address.addr.sin.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(coap_new_endpoint(control->context, &address, COAP_PROTO_UDP) == NULL)
+    {
+        ESP_LOGE(tag_coap_control, "Failed to create CoAP Endpoint on port %u!", port);
+        coap_free_context(control->context);
+        free(control);
+        return NULL;
+    }
+
+    rate = add_resource(control, "config/rate");
+    codec = add_resource(control, "config/codec");
+    measurement = add_resource(control, "control/start");
+    control->stats = add_resource(control, "stats");
+    if(rate == NULL || codec == NULL || measurement == NULL || control->stats == NULL)
+    {
+        coap_free_context(control->context);
+        free(control);
+        return NULL;
+    }
+
+    coap_register_request_handler(rate, COAP_REQUEST_GET, rate_get_handler);
+    coap_register_request_handler(rate, COAP_REQUEST_PUT, rate_put_handler);
+    coap_register_request_handler(codec, COAP_REQUEST_GET, codec_get_handler);
+    coap_register_request_handler(codec, COAP_REQUEST_PUT, codec_put_handler);
+    coap_register_request_handler(measurement, COAP_REQUEST_PUT, start_handler);
+    coap_register_request_handler(measurement, COAP_REQUEST_POST, start_handler);
+    coap_register_request_handler(control->stats, COAP_REQUEST_GET, stats_get_handler);
+    coap_resource_set_get_observable(control->stats, 1);
+    coap_add_attr(control->stats, coap_make_str_const("obs"), NULL, 0);
+
+    control->pool = pool;
+    control->bitrate = bitrate;
+    control->sensorRate = sensorRate;
+    control->start = start;
+
+    ESP_LOGI(tag_coap_control, "Control Resources on port %u", port);
+
+    return control;
+}
+
+int coap_control_discovery(coap_control_t *control, void (*enroll)(uint8_t sensorID, const struct sockaddr_in *server))
+{
+    coap_resource_t *resource;
+
+    if(coap_join_mcast_group_intf(control->context, COAP_CONTROL_GROUP, NULL) < 0)
+    {
+        ESP_LOGE(tag_coap_control, "Failed to join %s!", COAP_CONTROL_GROUP);
+        return -1;
+    }
+
+    resource = add_resource(control, "config/enroll");
+    if(resource == NULL)
+    {
+        return -1;
+    }
+    coap_register_request_handler(resource, COAP_REQUEST_PUT, enroll_put_handler);
+    coap_add_attr(resource, coap_make_str_const("rt"), coap_make_str_const(COAP_CONTROL_RESOURCE_TYPE), 0);
+    control->enroll = enroll;
+
+    ESP_LOGI(tag_coap_control, "Discovery in %s, waiting for Enrollment", COAP_CONTROL_GROUP);
+
+    return 1;
+}
+
+int coap_control_process(coap_control_t *control, uint32_t timeout_ms, int nfds, fd_set *readfds)
+{
+    if(coap_io_process_with_fds(control->context, timeout_ms, readfds ? nfds : 0, readfds, NULL, NULL) < 0)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+void coap_control_stats_changed(coap_control_t *control)
+{
+    coap_resource_notify_observers(control->stats, NULL);
+}
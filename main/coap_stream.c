@@ -0,0 +1,648 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "lwip/sockets.h"
+#include "coap3/coap.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "coap_stream.h"
+
+static const char *tag_coap = "CoAP-Client";
+
+/**
+ * @brief Hand a PDU to libcoap and measure the Time, over DTLS this includes the Record Encryption
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param pdu PDU to send, owned by libcoap afterwards
+ * @return coap_mid_t Message ID // COAP_INVALID_MID if send failed
+ */
+static coap_mid_t timed_send(coap_stream_t *stream, coap_pdu_t *pdu)
+{
+    int64_t start = esp_timer_get_time();
+    coap_mid_t mid = coap_send(stream->session, pdu);
+    uint32_t duration = esp_timer_get_time() - start;
+
+    stream->stats.sends++;
+    stream->stats.sendUs += duration;
+    if(duration > stream->stats.sendMaxUs)
+    {
+        stream->stats.sendMaxUs = duration;
+    }
+
+    return mid;
+}
+
+/**
+ * @brief Format a PDU with new Token, Content-Format and a reserved Payload Area, so sending only writes MID and Payload
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param entry Pool Entry to fill
+ * @param length Size of the Payload Area
+ * @return -1 if allocation failed // 1 if PDU is ready
+ */
+static int prepare_pdu(coap_stream_t *stream, struct coap_stream_pdu *entry, size_t length)
+{
+    coap_pdu_builder_t builder;
+    uint8_t token[8];
+    size_t tokenLength;
+
+    coap_session_new_token(stream->session, &tokenLength, token);
+    coap_pdu_builder_init(&builder, COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST);
+    coap_pdu_builder_add_token(&builder, tokenLength, token);
+    coap_pdu_builder_add_option(&builder, COAP_OPTION_CONTENT_TYPE, stream->contentTypeLength, stream->contentType);
+    coap_pdu_builder_add_data(&builder, length, NULL);
+
+    // One Allocation of the exact Size, the Payload Area is reserved and filled while sending
+    entry->pdu = coap_pdu_builder_build(&builder, 0, coap_session_max_pdu_size(stream->session), &entry->payload);
+    if(entry->pdu == NULL)
+    {
+        return -1;
+    }
+    entry->length = length;
+
+    return 1;
+}
+
+/**
+ * @brief Format PDUs for the Payload Size of the last single-PDU Frame until the Pool is full
+ *
+ * @param stream Pointer to CoAP Stream
+ */
+static void fill_pdu_pool(coap_stream_t *stream)
+{
+    while(stream->pduLength > 0 && stream->pduCount < COAP_STREAM_PDU_POOL_SIZE)
+    {
+        if(prepare_pdu(stream, &stream->pdus[stream->pduCount], stream->pduLength) < 0)
+        {
+            return;
+        }
+        stream->pduCount++;
+    }
+}
+
+/**
+ * @brief Delete the preformatted PDUs, they carry Tokens and Size Limit of the Session they were built for
+ *
+ * @param stream Pointer to CoAP Stream
+ */
+static void flush_pdu_pool(coap_stream_t *stream)
+{
+    while(stream->pduCount > 0)
+    {
+        stream->pduCount--;
+        coap_delete_pdu(stream->pdus[stream->pduCount].pdu);
+    }
+}
+
+/**
+ * @brief Largest Frame which fits into one PDU of the current Session. Not cached: a failed DTLS Session is replaced, the
+ * DTLS Overhead is known after the Handshake and over TCP/WebSocket the Limit is the Max-Message-Size of the Server CSM
+ *
+ * @param stream Pointer to CoAP Stream
+ * @return size_t Payload Bytes // 0 if not even the Header fits
+ */
+static size_t max_payload(coap_stream_t *stream)
+{
+    // Token (8 Bytes), Content-Format (1 Byte Option Header + Value) and Payload Marker in front of the Payload
+    size_t overhead = 8 + (1 + stream->contentTypeLength) + 1;
+    size_t maxPdu = coap_session_max_pdu_size(stream->session);
+
+    if(stream->oscoreConf != NULL)
+    {
+        overhead += COAP_STREAM_OSCORE_OVERHEAD;
+    }
+
+    return (maxPdu > overhead) ? maxPdu - overhead : 0;
+}
+
+/**
+ * @brief Send a Frame which fits into one PDU from the Pool
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param frame Frame to send
+ * @return -1 if send failed // 1 if send successfull
+ */
+static int send_single_pdu(coap_stream_t *stream, frame_t *frame)
+{
+    struct coap_stream_pdu entry;
+    size_t length = frame->length * sizeof(uint32_t);
+
+    // Frame Size changed (Frame Mode or Bitrate Profile): the Pool is formatted again for the new Size
+    if(length != stream->pduLength)
+    {
+        flush_pdu_pool(stream);
+        stream->pduLength = length;
+    }
+
+    if(stream->pduCount > 0)
+    {
+        stream->pduCount--;
+        entry = stream->pdus[stream->pduCount];
+    }
+    else
+    {
+        stream->stats.pduPoolMisses++;
+        if(prepare_pdu(stream, &entry, length) < 0)
+        {
+            return -1;
+        }
+    }
+
+    coap_pdu_set_mid(entry.pdu, coap_new_message_id(stream->session));
+    memcpy(entry.payload, frame->data, length);
+
+    if(timed_send(stream, entry.pdu) == COAP_INVALID_MID)
+    {
+        ESP_LOGE(tag_coap, "Send Failed!");
+        stream->stats.sendFailed++;
+        return -1;
+    }
+    stream->stats.requests++;
+
+    return 1;
+}
+
+/**
+ * @brief PROBING_RATE: while the Server does not respond, NON Traffic is limited to COAP_STREAM_PROBING_RATE Bytes/s.
+ * A responding Server gets the full Sensor Rate
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param length Bytes of the next Frame
+ * @return bool TRUE if the Frame may be send now // else FALSE
+ */
+static bool probing_allows(coap_stream_t *stream, size_t length)
+{
+    int64_t now = esp_timer_get_time();
+    uint64_t credit;
+
+    // TCP and WebSocket are paced by the TCP Congestion Control
+    if(COAP_PROTO_RELIABLE(stream->proto) || now - stream->lastResponse < COAP_STREAM_SILENCE_US)
+    {
+        stream->lastCredit = now;
+        stream->credit = 0;
+        return true;
+    }
+
+    // Credit for at most one Frame, so a long Silence does not allow a Burst
+    credit = stream->credit + ((uint64_t)(now - stream->lastCredit) * coap_session_get_probing_rate(stream->session)) / 1000000;
+    stream->credit = (credit > length) ? length : credit;
+    stream->lastCredit = now;
+    if(stream->credit < length)
+    {
+        return false;
+    }
+
+    stream->credit -= length;
+    return true;
+}
+
+/**
+ * @brief Called by libcoap when the Large-Body Transfer of a Frame is finished or failed. Releases the Frame to the Pool
+ *
+ * @param session Session of the Transfer
+ * @param app_ptr Frame
+ */
+static void release_frame_data(coap_session_t *session, void *app_ptr)
+{
+    coap_stream_t *stream = coap_session_get_app_data(session);
+
+    release_frame(stream->pool, (frame_t *)app_ptr);
+    stream->inFlight--;
+    stream->stats.released++;
+}
+
+/**
+ * @brief Count final Responses of the Server. 2.31 Continue of Q-Block1 is handled inside libcoap
+ *
+ */
+static coap_response_t response_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_pdu_t *received,
+                                        const coap_mid_t mid)
+{
+    coap_stream_t *stream = coap_session_get_app_data(session);
+
+    // Any Response shows the Server is alive, even 2.31 Continue or an Error
+    stream->lastResponse = esp_timer_get_time();
+    if(COAP_RESPONSE_CLASS(coap_pdu_get_code(received)) == 2)
+    {
+        stream->stats.responses++;
+    }
+    else
+    {
+        stream->stats.errors++;
+    }
+
+    return COAP_RESPONSE_OK;
+}
+
+/**
+ * @brief Count Requests which got no Response (Timeout) or a Reset
+ *
+ */
+static void nack_handler(coap_session_t *session, const coap_pdu_t *sent, const coap_nack_reason_t reason,
+                         const coap_mid_t mid)
+{
+    coap_stream_t *stream = coap_session_get_app_data(session);
+
+    stream->stats.errors++;
+}
+
+/**
+ * @brief Count DTLS Handshakes and replace a failed DTLS Session. Events of a replaced Session are ignored
+ *
+ */
+static int event_handler(coap_session_t *session, const coap_event_t event)
+{
+    coap_stream_t *stream = coap_session_get_app_data(session);
+
+    if(stream == NULL || session != stream->session)
+    {
+        return 0;
+    }
+
+    switch(event)
+    {
+        case COAP_EVENT_DTLS_CONNECTED:
+            stream->stats.handshakes++;
+            stream->stats.handshakeUs = esp_timer_get_time() - stream->sessionStart;
+            break;
+        case COAP_EVENT_DTLS_CLOSED:
+        case COAP_EVENT_DTLS_ERROR:
+        case COAP_EVENT_SESSION_FAILED:
+            stream->reconnect = true;
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the DTLS PSK Identity and Key from NVS (COAP_STREAM_PSK_NAMESPACE)
+ *
+ * @param stream Pointer to CoAP Stream
+ * @return -1 if no PSK is provisioned // 1 if PSK loaded
+ */
+static int load_psk(coap_stream_t *stream)
+{
+    nvs_handle_t handle;
+    size_t length;
+    esp_err_t err;
+
+    if(nvs_open(COAP_STREAM_PSK_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return -1;
+    }
+
+    length = sizeof(stream->pskIdentity);
+    err = nvs_get_str(handle, "psk_id", (char *)stream->pskIdentity, &length);
+    stream->pskIdentityLength = (length > 0) ? length - 1 : 0;
+    if(err == ESP_OK)
+    {
+        length = sizeof(stream->pskKey);
+        err = nvs_get_blob(handle, "psk_key", stream->pskKey, &length);
+        stream->pskKeyLength = length;
+    }
+    nvs_close(handle);
+
+    if(err != ESP_OK || stream->pskIdentityLength == 0 || stream->pskKeyLength == 0)
+    {
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Called by libcoap every COAP_STREAM_OSCORE_SSN_FREQ Sender Sequence Numbers. After a Reboot the OSCORE Context
+ * starts with the saved Number, so no Nonce is used twice
+ *
+ * @param sender_seq_num Sequence Number which is not used yet
+ * @param param CoAP Stream
+ * @return 0 if NVS Write failed // 1 if saved
+ */
+static int save_oscore_ssn(uint64_t sender_seq_num, void *param)
+{
+    coap_stream_t *stream = param;
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    stream->oscoreSsn = sender_seq_num;
+    if(nvs_open(COAP_STREAM_PSK_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return 0;
+    }
+    err = nvs_set_u64(handle, "oscore_ssn", sender_seq_num);
+    if(err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    return err == ESP_OK;
+}
+
+/**
+ * @brief Read the OSCORE Configuration and the saved Sender Sequence Number from NVS. Without ssn_freq in the
+ * Configuration, COAP_STREAM_OSCORE_SSN_FREQ is added, libcoap would write NVS for every Frame otherwise
+ *
+ * @param stream Pointer to CoAP Stream
+ * @return -1 if no Configuration is provisioned // 1 if Configuration loaded
+ */
+static int load_oscore_conf(coap_stream_t *stream)
+{
+    nvs_handle_t handle;
+    size_t length = COAP_STREAM_OSCORE_MAX_CONF;
+    esp_err_t err;
+
+    stream->oscoreConf = calloc(1, COAP_STREAM_OSCORE_MAX_CONF + 32);
+    if(stream->oscoreConf == NULL)
+    {
+        return -1;
+    }
+    if(nvs_open(COAP_STREAM_PSK_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        free(stream->oscoreConf);
+        stream->oscoreConf = NULL;
+        return -1;
+    }
+    err = nvs_get_str(handle, "oscore_conf", stream->oscoreConf, &length);
+    if(nvs_get_u64(handle, "oscore_ssn", &stream->oscoreSsn) != ESP_OK)
+    {
+        stream->oscoreSsn = 0;
+    }
+    nvs_close(handle);
+
+    if(err != ESP_OK)
+    {
+        free(stream->oscoreConf);
+        stream->oscoreConf = NULL;
+        return -1;
+    }
+    if(strstr(stream->oscoreConf, "ssn_freq") == NULL)
+    {
+        snprintf(stream->oscoreConf + strlen(stream->oscoreConf), 32, "\nssn_freq,integer,%d\n",
+                 COAP_STREAM_OSCORE_SSN_FREQ);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Create the Client Session to the Server with NSTART and Probing Rate. Over DTLS libcoap offers the last
+ * established DTLS Session for Resumption, so a Reconnect needs only the abbreviated Handshake
+ *
+ * @param stream Pointer to CoAP Stream
+ * @return -1 if Session could not be created // 1 if Session is created
+ */
+static int open_session(coap_stream_t *stream)
+{
+    coap_dtls_cpsk_t psk;
+    coap_oscore_conf_t *oscore = NULL;
+    coap_str_const_t conf;
+
+    stream->sessionStart = esp_timer_get_time();
+    memset(&psk, 0, sizeof(psk));
+    psk.version = COAP_DTLS_CPSK_SETUP_VERSION;
+    psk.psk_info.identity.s = stream->pskIdentity;
+    psk.psk_info.identity.length = stream->pskIdentityLength;
+    psk.psk_info.key.s = stream->pskKey;
+    psk.psk_info.key.length = stream->pskKeyLength;
+
+    // Key Derivation happens once here, the Session keeps the derived OSCORE Context
+    if(stream->oscoreConf != NULL)
+    {
+        conf.s = (const uint8_t *)stream->oscoreConf;
+        conf.length = strlen(stream->oscoreConf);
+        oscore = coap_new_oscore_conf(conf, save_oscore_ssn, stream, stream->oscoreSsn);
+        if(oscore == NULL)
+        {
+            ESP_LOGE(tag_coap, "Invalid OSCORE Configuration!");
+            return -1;
+        }
+    }
+
+    if(oscore != NULL && stream->proto == COAP_PROTO_DTLS)
+    {
+        stream->session = coap_new_client_session_oscore_psk(stream->context, NULL, &stream->server, stream->proto,
+                                                             &psk, oscore);
+    }
+    else if(oscore != NULL)
+    {
+        stream->session = coap_new_client_session_oscore(stream->context, NULL, &stream->server, stream->proto, oscore);
+    }
+    else if(stream->proto == COAP_PROTO_DTLS)
+    {
+        stream->session = coap_new_client_session_psk2(stream->context, NULL, &stream->server, stream->proto, &psk);
+    }
+    else
+    {
+        stream->session = coap_new_client_session(stream->context, NULL, &stream->server, stream->proto);
+    }
+    if(stream->session == NULL)
+    {
+        ESP_LOGE(tag_coap, "Failed to create CoAP Session (Protocol %d)!", stream->proto);
+        return -1;
+    }
+    coap_session_set_app_data(stream->session, stream);
+    stream->reconnect = false;
+
+    // NSTART limits CON Messages in libcoap (Q-Block Probes) and the Block Transfers started here
+    coap_session_set_nstart(stream->session, COAP_STREAM_NSTART);
+    coap_session_set_probing_rate(stream->session, COAP_STREAM_PROBING_RATE);
+
+    return 1;
+}
+
+coap_stream_t *init_coap_stream(frame_pool_handle_t *pool, const struct sockaddr_in *server, coap_proto_t proto,
+                                bool oscore, int notifyFd)
+{
+    coap_stream_t *stream;
+
+    stream = calloc(1, sizeof(coap_stream_t));
+    if(stream == NULL)
+    {
+        return NULL;
+    }
+
+    coap_startup();
+
+    stream->context = coap_new_context(NULL);
+    if(stream->context == NULL)
+    {
+        free(stream);
+        return NULL;
+    }
+
+    // libcoap splits Frames into Blocks and recovers lost Blocks itself. Q-Block1 is used if the Server supports it. The
+    // Q-Block Probe of an OSCORE Session is only send after the first Response Timeout (5 s), so OSCORE uses Block1
+    coap_context_set_block_mode(stream->context, COAP_BLOCK_USE_LIBCOAP | COAP_BLOCK_SINGLE_BODY |
+                                                 (oscore ? 0 : COAP_BLOCK_TRY_Q_BLOCK));
+    if(!coap_q_block_is_supported())
+    {
+        ESP_LOGE(tag_coap, "libcoap without Q-Block, using Block1 (CONFIG_COAP_Q_BLOCK)");
+    }
+    if(COAP_PROTO_RELIABLE(proto))
+    {
+        coap_context_set_csm_max_message_size(stream->context, COAP_STREAM_CSM_MAX_MESSAGE_SIZE);
+    }
+    coap_register_response_handler(stream->context, response_handler);
+    coap_register_nack_handler(stream->context, nack_handler);
+    coap_register_event_handler(stream->context, event_handler);
+
+    coap_address_init(&stream->server);
+    stream->server.addr.sin = *server;
+    stream->proto = proto;
+    stream->pool = pool;
+    stream->notifyFd = notifyFd;
+
+    if(proto == COAP_PROTO_DTLS && load_psk(stream) < 0)
+    {
+        ESP_LOGE(tag_coap, "No DTLS PSK in NVS Namespace %s!", COAP_STREAM_PSK_NAMESPACE);
+        coap_free_context(stream->context);
+        free(stream);
+        return NULL;
+    }
+    if(oscore && load_oscore_conf(stream) < 0)
+    {
+        ESP_LOGE(tag_coap, "No OSCORE Configuration in NVS Namespace %s!", COAP_STREAM_PSK_NAMESPACE);
+        coap_free_context(stream->context);
+        free(stream);
+        return NULL;
+    }
+    if(open_session(stream) < 0)
+    {
+        coap_free_context(stream->context);
+        free(stream->oscoreConf);
+        free(stream);
+        return NULL;
+    }
+    stream->lastResponse = esp_timer_get_time();
+    stream->lastCredit = stream->lastResponse;
+
+    stream->contentTypeLength = coap_encode_var_safe(stream->contentType, sizeof(stream->contentType),
+                                                     COAP_MEDIATYPE_APPLICATION_OCTET_STREAM);
+
+    ESP_LOGI(tag_coap, "CoAP Session created (Protocol %d), max PDU Size %u Bytes", proto,
+             (unsigned)coap_session_max_pdu_size(stream->session));
+
+    return stream;
+}
+
+int coap_stream_send_frame(coap_stream_t *stream, frame_t *frame)
+{
+    coap_pdu_t *pdu;
+    uint8_t token[8];
+    size_t tokenLength;
+    size_t length = frame->length * sizeof(uint32_t);
+
+    // Frames wait in the Transmit Queue while a failed DTLS Session is replaced
+    if(stream->session == NULL)
+    {
+        return 0;
+    }
+
+    if(!probing_allows(stream, length))
+    {
+        stream->stats.probingLimited++;
+        return 0;
+    }
+
+    if(length <= max_payload(stream))
+    {
+        return send_single_pdu(stream, frame);
+    }
+
+    if(stream->inFlight >= coap_session_get_nstart(stream->session))
+    {
+        stream->stats.nstartLimited++;
+        return 0;
+    }
+
+    pdu = coap_new_pdu(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, stream->session);
+    if(pdu == NULL)
+    {
+        stream->stats.sendFailed++;
+        return -1;
+    }
+
+    stream->stats.blockwise++;
+
+    // Token matches Responses and the Blocks of one Frame
+    coap_session_new_token(stream->session, &tokenLength, token);
+    coap_add_token(pdu, tokenLength, token);
+    coap_add_option(pdu, COAP_OPTION_CONTENT_TYPE, stream->contentTypeLength, stream->contentType);
+
+    // Frame Data is referenced, not copied. release_frame_data() drops the Reference
+    hold_frame(frame);
+    stream->inFlight++;
+    if(stream->inFlight > stream->stats.inFlightHighWater)
+    {
+        stream->stats.inFlightHighWater = stream->inFlight;
+    }
+    if(!coap_add_data_large_request(stream->session, pdu, length, (const uint8_t *)frame->data, release_frame_data, frame))
+    {
+        // libcoap calls release_func on Failure too
+        coap_delete_pdu(pdu);
+        stream->stats.sendFailed++;
+        return -1;
+    }
+
+    if(timed_send(stream, pdu) == COAP_INVALID_MID)
+    {
+        ESP_LOGE(tag_coap, "Send Failed!");
+        stream->stats.sendFailed++;
+        return -1;
+    }
+    stream->stats.requests++;
+
+    return 1;
+}
+
+void coap_stream_process(coap_stream_t *stream, uint32_t timeout_ms)
+{
+    fd_set readfds;
+    uint64_t events;
+    coap_session_t *session;
+
+    if(stream->notifyFd < 0)
+    {
+        coap_io_process(stream->context, timeout_ms);
+    }
+    else
+    {
+        // One select() over the libcoap Sockets and the Frame eventfd
+        FD_ZERO(&readfds);
+        FD_SET(stream->notifyFd, &readfds);
+        coap_io_process_with_fds(stream->context, timeout_ms, stream->notifyFd + 1, &readfds, NULL, NULL);
+        if(FD_ISSET(stream->notifyFd, &readfds))
+        {
+            read(stream->notifyFd, &events, sizeof(events));
+        }
+    }
+
+    // The Session is set to NULL first, so the Events of the old Session are ignored
+    if(stream->reconnect || stream->session == NULL)
+    {
+        if(stream->session != NULL)
+        {
+            session = stream->session;
+            stream->session = NULL;
+            coap_session_release(session);
+            flush_pdu_pool(stream);
+            stream->stats.reconnects++;
+        }
+        if(open_session(stream) < 0)
+        {
+            return;
+        }
+    }
+    fill_pdu_pool(stream);
+}
@@ -22,5 +22,39 @@
 #define LOCALHOST_PORT 50000
 
 #define SETTINGS_PORT 51234
+// 1 --> CoAP Resources /config/rate, /config/codec, /control/start and /stats on COAP_CONTROL_PORT of the Sensor
+#define COAP_CONTROL 1
+#define COAP_CONTROL_PORT 5685
+// 1 --> Sensor joins All-CoAP-Nodes on COAP_CONTROL_PORT and waits for Enrollment by a Collector (PUT /config/enroll),
+// LOCALHOST_ADDRESS and COAP_SERVERADDRESS are not used (needs COAP_CONTROL)
+#define COAP_DISCOVERY 0
+
+// 1 --> NACK-driven Retransmission of lost UDP Frames, every Frame starts with a Sequence Number Word before the first
+// SensorID Word (the Receiver has to parse it), 0 --> Frame Format without Sequence Number, NACKs are ignored
+#define ARQ_ENABLE 0
+
+// Transport for Sensordata: 0 --> UDP to registered Server, 1 --> TCP to TCP_STREAM_PORT of registered Server (lossless)
+#define STREAM_TRANSPORT_TCP 0
+#define TCP_STREAM_PORT 50002
+
+// 1 --> CoAP POST with Q-Block1 to COAP_SERVERADDRESS (overrides STREAM_TRANSPORT_TCP), enable CONFIG_COAP_MEM_POOL with
+// it to take its Messages from the libcoap Pools (off by default, the Body Blocks alone reserve ~40 KB)
+#define STREAM_TRANSPORT_COAP 0
+// CoAP Transport: 0 --> UDP to COAP_PORT, 1 --> TCP to COAP_PORT, 2 --> WebSocket to COAP_WS_PORT (CONFIG_COAP_WEBSOCKETS),
+// 3 --> DTLS-PSK to COAP_DTLS_PORT, PSK from NVS Namespace "coap" ("psk_id" String, "psk_key" Blob)
+#define COAP_STREAM_PROTOCOL 0
+#define COAP_WS_PORT 80
+#define COAP_DTLS_PORT 5684
+// 1 --> CoAP Requests protected end-to-end by OSCORE (CONFIG_COAP_OSCORE_SUPPORT), Configuration from NVS Namespace
+// "coap" ("oscore_conf" String in libcoap OSCORE Configuration Format), works with every COAP_STREAM_PROTOCOL
+#define COAP_STREAM_OSCORE 0
+
+// 1 --> Observable CoAP Resource /audio on COAP_PORT of the Sensor, every Observer gets each Frame (overrides the others)
+#define STREAM_TRANSPORT_COAP_OBSERVE 0
+
+// Additional Stream to a Multicast Group, "" --> only Unicast to registered Server
+#define MULTICAST_ADDRESS ""
+#define MULTICAST_PORT 50001
+#define MULTICAST_TTL 1
 
 #endif
\ No newline at end of file
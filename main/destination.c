@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+
+// Custom Headerfiles
+#include "destination.h"
+
+/**
+ * @brief Compare IPv4 Address and Port of two Receivers
+ *
+ * @return bool TRUE if both are the same Receiver // else FALSE
+ */
+static bool same_destination(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+destination_list_t *init_destinations(void)
+{
+    destination_list_t *list;
+
+    list = calloc(1, sizeof(destination_list_t));
+    if(list == NULL)
+    {
+        return NULL;
+    }
+
+    list->mutex = xSemaphoreCreateMutex();
+    if(list->mutex == NULL)
+    {
+        free(list);
+        return NULL;
+    }
+
+    return list;
+}
+
+int add_destination(destination_list_t *list, const struct sockaddr_in *addr)
+{
+    int ret = 1;
+
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    for(uint i = 0; i < list->count; i++)
+    {
+        if(same_destination(&list->addr[i], addr))
+        {
+            ret = 0;
+            break;
+        }
+    }
+
+    if(ret == 1)
+    {
+        if(list->count < DESTINATION_MAX)
+        {
+            list->addr[list->count] = *addr;
+            memset(&list->stats[list->count], 0, sizeof(destination_stats_t));
+            list->count++;
+        }
+        else
+        {
+            ret = -1;
+        }
+    }
+    xSemaphoreGive(list->mutex);
+
+    return ret;
+}
+
+int remove_destination(destination_list_t *list, const struct sockaddr_in *addr)
+{
+    int ret = -1;
+
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    for(uint i = 0; i < list->count; i++)
+    {
+        if(same_destination(&list->addr[i], addr))
+        {
+            // Move last Receiver into the Gap
+            list->addr[i] = list->addr[list->count - 1];
+            list->stats[i] = list->stats[list->count - 1];
+            list->count--;
+            ret = 1;
+            break;
+        }
+    }
+    xSemaphoreGive(list->mutex);
+
+    return ret;
+}
+
+uint copy_destinations(destination_list_t *list, struct sockaddr_in *addr)
+{
+    uint count;
+
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    count = list->count;
+    memcpy(addr, list->addr, count * sizeof(struct sockaddr_in));
+    xSemaphoreGive(list->mutex);
+
+    return count;
+}
+
+int find_destination(destination_list_t *list, struct in_addr ip, struct sockaddr_in *addr)
+{
+    int ret = -1;
+
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    for(uint i = 0; i < list->count; i++)
+    {
+        if(list->addr[i].sin_addr.s_addr == ip.s_addr)
+        {
+            *addr = list->addr[i];
+            ret = 1;
+            break;
+        }
+    }
+    xSemaphoreGive(list->mutex);
+
+    return ret;
+}
+
+void count_destination(destination_list_t *list, const struct sockaddr_in *addr, bool sent)
+{
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    for(uint i = 0; i < list->count; i++)
+    {
+        if(same_destination(&list->addr[i], addr))
+        {
+            if(sent)
+            {
+                list->stats[i].sent++;
+            }
+            else
+            {
+                list->stats[i].failed++;
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(list->mutex);
+}
+
+uint copy_destination_stats(destination_list_t *list, struct sockaddr_in *addr, destination_stats_t *stats)
+{
+    uint count;
+
+    xSemaphoreTake(list->mutex, (TickType_t) portMAX_DELAY);
+    count = list->count;
+    memcpy(addr, list->addr, count * sizeof(struct sockaddr_in));
+    memcpy(stats, list->stats, count * sizeof(destination_stats_t));
+    xSemaphoreGive(list->mutex);
+
+    return count;
+}
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+
+/**
+ * @brief Pop the oldest Frame from the Transmit Ring. Safe against the second Consumer (Drop Oldest)
+ *
+ * @param pool Pointer to Frame Pool
+ * @return frame_t* Oldest Frame // NULL if Ring is empty
+ */
+static frame_t *pop_frame(frame_pool_handle_t *pool)
+{
+    uint tail = atomic_load_explicit(&pool->txTail, memory_order_acquire);
+    frame_t *frame;
+
+    do
+    {
+        if(tail == atomic_load_explicit(&pool->txHead, memory_order_acquire))
+        {
+            return NULL;
+        }
+        frame = atomic_load_explicit(&pool->txRing[tail & pool->txRingMask], memory_order_relaxed);
+    } while(!atomic_compare_exchange_weak_explicit(&pool->txTail, &tail, tail + 1, memory_order_acq_rel, memory_order_acquire));
+
+    return frame;
+}
+
+/**
+ * @brief Free a partly initialized Pool: Frame Data, Frames, Transmit Ring, freeQueue and the Pool itself
+ *
+ * @param pool Pointer to Frame Pool, Members not allocated yet are NULL
+ * @param count Number of Frames
+ */
+static void free_frame_pool(frame_pool_handle_t *pool, uint count)
+{
+    if(pool->frames != NULL)
+    {
+        for(uint i = 0; i < count; i++)
+        {
+            free(pool->frames[i].data);
+        }
+    }
+    if(pool->freeQueue != NULL)
+    {
+        vQueueDelete(pool->freeQueue);
+    }
+    free(pool->txRing);
+    free(pool->frames);
+    free(pool);
+}
+
+// Init of Frame Pool. All Frames are allocated here and circulate between freeQueue and txQueue afterwards
+frame_pool_handle_t *init_frame_pool(uint count, uint size, frame_drop_policy_t policy)
+{
+    frame_pool_handle_t *pool;
+    uint ringSize = 1;
+
+    // Allocate Memory for Pool
+    pool = calloc(1, sizeof(frame_pool_handle_t));
+    if(pool == NULL)
+    {
+        return NULL;
+    }
+
+    pool->frames = calloc(count, sizeof(frame_t));
+    if(pool->frames == NULL)
+    {
+        free_frame_pool(pool, count);
+        return NULL;
+    }
+
+    // Queue and Ring can hold every Frame, so a Push to them never fails
+    pool->freeQueue = xQueueCreate(count, sizeof(frame_t *));
+    while(ringSize < count)
+    {
+        ringSize <<= 1;
+    }
+    pool->txRing = calloc(ringSize, sizeof(frame_t *));
+    pool->txRingMask = ringSize - 1;
+    if(pool->freeQueue == NULL || pool->txRing == NULL)
+    {
+        free_frame_pool(pool, count);
+        return NULL;
+    }
+
+    // Allocate Frame Data and fill freeQueue
+    for(uint i = 0; i < count; i++)
+    {
+        frame_t *frame = &pool->frames[i];
+
+        frame->data = malloc(sizeof(uint32_t) * size);
+        if(frame->data == NULL)
+        {
+            free_frame_pool(pool, count);
+            return NULL;
+        }
+        frame->size = size;
+        frame->length = 0;
+        xQueueSend(pool->freeQueue, &frame, 0);
+    }
+
+    pool->count = count;
+    pool->policy = policy;
+    pool->notifyFd = -1;
+
+    return pool;
+}
+
+frame_t *get_free_frame(frame_pool_handle_t *pool, TickType_t wait)
+{
+    frame_t *frame = NULL;
+
+    if(xQueueReceive(pool->freeQueue, &frame, wait) == pdTRUE)
+    {
+        frame->length = 0;
+        atomic_store(&frame->refs, 1);
+        return frame;
+    }
+
+    // Pool is empty: every Frame is waiting for the Link
+    if(pool->policy == FRAME_DROP_OLDEST && (frame = pop_frame(pool)) != NULL)
+    {
+        atomic_fetch_add(&pool->stats.droppedOldest, 1);
+        frame->length = 0;
+        return frame;
+    }
+
+    atomic_fetch_add(&pool->stats.droppedNewest, 1);
+    return NULL;
+}
+
+void submit_frame(frame_pool_handle_t *pool, frame_t *frame)
+{
+    uint head = atomic_load_explicit(&pool->txHead, memory_order_relaxed);
+    uint waiting;
+
+    atomic_store_explicit(&pool->txRing[head & pool->txRingMask], frame, memory_order_relaxed);
+    atomic_store_explicit(&pool->txHead, head + 1, memory_order_release);
+    atomic_fetch_add(&pool->stats.captured, 1);
+
+    if(pool->notifyFd >= 0)
+    {
+        uint64_t event = 1;
+        write(pool->notifyFd, &event, sizeof(event));
+    }
+    else if(pool->consumer != NULL)
+    {
+        xTaskNotifyGive(pool->consumer);
+    }
+
+    waiting = queued_frames(pool);
+    if(waiting > atomic_load(&pool->stats.queueHighWater))
+    {
+        atomic_store(&pool->stats.queueHighWater, waiting);
+    }
+}
+
+frame_t *receive_frame(frame_pool_handle_t *pool, TickType_t wait)
+{
+    frame_t *frame;
+
+    pool->consumer = xTaskGetCurrentTaskHandle();
+
+    frame = pop_frame(pool);
+    if(frame == NULL && wait > 0)
+    {
+        ulTaskNotifyTake(pdTRUE, wait);
+        frame = pop_frame(pool);
+    }
+
+    return frame;
+}
+
+void set_frame_notify_fd(frame_pool_handle_t *pool, int fd)
+{
+    pool->notifyFd = fd;
+}
+
+void hold_frame(frame_t *frame)
+{
+    atomic_fetch_add(&frame->refs, 1);
+}
+
+void release_frame(frame_pool_handle_t *pool, frame_t *frame)
+{
+    if(atomic_fetch_sub(&frame->refs, 1) == 1)
+    {
+        xQueueSend(pool->freeQueue, &frame, 0);
+    }
+}
+
+uint queued_frames(frame_pool_handle_t *pool)
+{
+    return atomic_load(&pool->txHead) - atomic_load(&pool->txTail);
+}
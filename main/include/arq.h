@@ -0,0 +1,128 @@
+/**
+ * @file arq.h
+ * @brief NACK-driven selective Retransmission from a History of sent Frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __ARQ_H__
+#define __ARQ_H__
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "lwip/sockets.h"
+#include "frame_pool.h"
+
+/**
+ * @brief Range of missing Sequence Numbers reported by the Server. first and last are included
+ *
+ */
+struct arq_range{
+    uint32_t first;
+    uint32_t last;
+    struct in_addr requester;   // IP of the Receiver which send the NACK
+};
+typedef struct arq_range arq_range_t;
+
+/**
+ * @brief Counters of the Retransmission, only read for Logging
+ *
+ */
+struct arq_stats{
+    uint32_t nacks;         // NACK Messages received
+    uint32_t retransmitted; // Frames send again
+    uint32_t notInHistory;  // Requested Frames which were already evicted or never send
+    uint32_t rateLimited;   // Times a Retransmission was postponed by the Rate Limit
+    uint32_t overflow;      // Ranges dropped because the Request Queue was full
+};
+typedef struct arq_stats arq_stats_t;
+
+/**
+ * @brief Struct and Typedef for Retransmission State. History is only accessed by the Send-Task
+ *
+ */
+struct arq_handle{
+    frame_t **history;      // Ringbuffer of sent Frames, oldest at historyTail
+    uint historySize;
+    uint historyCount;
+    uint historyTail;
+    QueueHandle_t requestQueue; // arq_range_t from Control-Task to Send-Task
+    arq_range_t current;
+    bool active;            // current Range is not finished yet
+    uint32_t tokens;        // Token Bucket for Rate Limit
+    uint32_t burst;
+    uint32_t rate;          // Retransmissions per second
+    int64_t lastRefill;
+    arq_stats_t stats;
+};
+typedef struct arq_handle arq_handle_t;
+
+/**
+ * @brief Initialize and allocate the Retransmission History
+ *
+ * @param historySize Number of sent Frames kept for Retransmission
+ * @param rate Maximum Retransmissions per second
+ * @param burst Maximum Retransmissions in a row
+ * @return arq_handle_t* Pointer to Retransmission State // NULL if allocation failed
+ */
+arq_handle_t *init_arq(uint historySize, uint rate, uint burst);
+
+/**
+ * @brief Keep a sent Frame in the History. If the History is full, the oldest Frame will be evicted
+ *
+ * @param arq Pointer to Retransmission State
+ * @param frame Frame which was send
+ * @return frame_t* Evicted Frame, which has to be released to the Frame Pool // NULL if nothing was evicted
+ */
+frame_t *arq_store_frame(arq_handle_t *arq, frame_t *frame);
+
+/**
+ * @brief Parse a NACK Message (Pairs of first/last Sequence Number in NBO) and queue the Ranges for the Send-Task
+ *
+ * @param arq Pointer to Retransmission State
+ * @param message Message without the Command Byte
+ * @param length Length of message in Bytes
+ * @param requester IP of the Receiver which send the NACK
+ * @return Number of queued Ranges // -1 if Message is malformed
+ */
+int arq_parse_nack(arq_handle_t *arq, const uint8_t *message, size_t length, struct in_addr requester);
+
+/**
+ * @brief Get the next requested Frame from the History, if the Rate Limit allows it
+ *
+ * @param arq Pointer to Retransmission State
+ * @param requester IP of the Receiver which requested the Frame
+ * @return frame_t* Frame to send again, stays in History // NULL if nothing to send
+ */
+frame_t *arq_next_retransmission(arq_handle_t *arq, struct in_addr *requester);
+
+/**
+ * @brief Check for open Retransmission Requests, e.g. to wake up the Send-Loop in time
+ *
+ * @param arq Pointer to Retransmission State
+ * @return bool TRUE if a Range is waiting // else FALSE
+ */
+bool arq_has_requests(arq_handle_t *arq);
+
+/**
+ * @brief Take the oldest Frame out of the History if the Receiver acknowledged it, e.g. for the TCP Stream, which keeps
+ * every unacknowledged Frame in the History instead of evicting it
+ *
+ * @param arq Pointer to Retransmission State
+ * @param seq Last Sequence Number the Receiver acknowledged
+ * @return frame_t* Acknowledged Frame, which has to be released to the Frame Pool // NULL if the oldest Frame is newer
+ */
+frame_t *arq_pop_acked(arq_handle_t *arq, uint32_t seq);
+
+/**
+ * @brief Get all Frames in the History which are newer than a Sequence Number, e.g. to resume a Stream
+ *
+ * @param arq Pointer to Retransmission State
+ * @param seq Last Sequence Number the Receiver has got
+ * @param frames Array with historySize Elements, oldest Frame first
+ * @return uint Number of Frames
+ */
+uint arq_history_after(arq_handle_t *arq, uint32_t seq, frame_t **frames);
+
+#endif
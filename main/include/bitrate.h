@@ -0,0 +1,102 @@
+/**
+ * @file bitrate.h
+ * @brief Adaptive Bitrate: steps between Sample Profiles with the Loss, Jitter and Throughput reported by the Receiver
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __BITRATE_H__
+#define __BITRATE_H__
+
+#include <stdint.h>
+
+#define BITRATE_LOSS_HIGH 20        // Loss in Permille, above this the next lower Profile is used
+#define BITRATE_LOSS_LOW 2          // Loss in Permille, below this a Report counts as clean
+#define BITRATE_JITTER_HIGH 20000   // Jitter in us, above this the next lower Profile is used
+#define BITRATE_THROUGHPUT_MIN 90   // Received Throughput in Percent of the Profile Bitrate, below this the Link is too slow
+#define BITRATE_UP_REPORTS 5        // Clean Reports in a Row before the next higher Profile is tried
+
+/**
+ * @brief Sample Profile of a Frame. Profile 0 is the full Fidelity
+ *
+ */
+struct bitrate_profile{
+    uint8_t decimation;     // Every n-th Sample is send
+    uint8_t sampleBits;     // 32 --> uint32_t per Sample // 16 --> two Samples per Word, low 16 Bit of each Sample
+};
+typedef struct bitrate_profile bitrate_profile_t;
+
+/**
+ * @brief Counters of the Controller, only read for Logging
+ *
+ */
+struct bitrate_stats{
+    uint32_t reports;       // Feedback Messages received
+    uint32_t stepsDown;
+    uint32_t stepsUp;
+    uint16_t lossPermille;  // Last Report
+    uint32_t jitterUs;      // Last Report
+    uint32_t throughputKbps;    // Last Report
+};
+typedef struct bitrate_stats bitrate_stats_t;
+
+/**
+ * @brief Struct and Typedef for Bitrate Controller. Written by the Network-Task, profile is read by the Collect-Task
+ *
+ */
+struct bitrate_handle{
+    volatile uint8_t profile;   // Index into the Profile Table
+    uint32_t fullKbps;      // Payload Bitrate of Profile 0
+    uint cleanReports;
+    bitrate_stats_t stats;
+};
+typedef struct bitrate_handle bitrate_handle_t;
+
+/**
+ * @brief Initialize Bitrate Controller with Profile 0
+ *
+ * @param fullKbps Payload Bitrate of the full Fidelity Profile in kbit/s
+ * @return bitrate_handle_t* Pointer to Bitrate Controller // NULL if allocation failed
+ */
+bitrate_handle_t *init_bitrate(uint32_t fullKbps);
+
+/**
+ * @brief Feed one Receiver Report into the Controller. Steps down at once on Loss, Jitter or missing Throughput, steps up
+ * after BITRATE_UP_REPORTS clean Reports
+ *
+ * @param bitrate Pointer to Bitrate Controller
+ * @param lossPermille Lost Frames in Permille since the last Report
+ * @param jitterUs Interarrival Jitter in us
+ * @param throughputKbps Received Payload Bitrate in kbit/s
+ * @return -1 if stepped down // 0 if unchanged // 1 if stepped up
+ */
+int bitrate_feedback(bitrate_handle_t *bitrate, uint16_t lossPermille, uint32_t jitterUs, uint32_t throughputKbps);
+
+/**
+ * @brief Select the Profile with decimation and sampleBits, e.g. set by the Server. Later Feedback steps from there
+ *
+ * @param bitrate Pointer to Bitrate Controller
+ * @param decimation Every n-th Sample is send
+ * @param sampleBits 32 or 16 Bits per Sample
+ * @return -1 if no Profile matches // 1 if Profile is set
+ */
+int bitrate_set_profile(bitrate_handle_t *bitrate, uint8_t decimation, uint8_t sampleBits);
+
+/**
+ * @brief Get the current Sample Profile
+ *
+ * @param bitrate Pointer to Bitrate Controller
+ * @return const bitrate_profile_t* Profile for the next Frame
+ */
+const bitrate_profile_t *bitrate_profile(bitrate_handle_t *bitrate);
+
+/**
+ * @brief Payload Bitrate of the current Profile
+ *
+ * @param bitrate Pointer to Bitrate Controller
+ * @return uint32_t Bitrate in kbit/s
+ */
+uint32_t bitrate_kbps(bitrate_handle_t *bitrate);
+
+#endif
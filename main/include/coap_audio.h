@@ -0,0 +1,74 @@
+/**
+ * @file coap_audio.h
+ * @brief Observable CoAP Resource /audio on the Sensor. Every Frame is pushed as NON Notification to all Observers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __COAP_AUDIO_H__
+#define __COAP_AUDIO_H__
+
+#include "coap3/coap.h"
+#include "frame_pool.h"
+
+#define COAP_AUDIO_PATH "audio"
+
+/**
+ * @brief Counters of the Observe Resource, only read for Logging
+ *
+ */
+struct coap_audio_stats{
+    uint32_t published;     // Frames handed to the Resource
+    uint32_t unobserved;    // Frames published without any Observer
+    uint32_t representations;   // Notifications and GET Responses built (GET Handler Calls)
+    uint32_t released;      // Frame References libcoap is done with
+};
+typedef struct coap_audio_stats coap_audio_stats_t;
+
+/**
+ * @brief Struct and Typedef for the Observe Resource. All Calls have to come from the same Task, libcoap is not thread-safe
+ *
+ */
+struct coap_audio{
+    coap_context_t *context;
+    coap_resource_t *resource;
+    frame_pool_handle_t *pool;
+    frame_t *frame;         // Latest published Frame, held until the next one, late Observers get this Frame
+    unsigned int observers; // Notifications and Responses built with the latest Frame
+    int notifyFd;           // eventfd of the Frame Pool, wakes up the I/O Loop for new Frames
+    coap_audio_stats_t stats;
+};
+typedef struct coap_audio coap_audio_t;
+
+/**
+ * @brief Initialize libcoap as Server on port and create the observable Resource /audio. Clients subscribe with
+ * GET + Observe and detach with Observe Deregistration or a RST, no Registration through the Settings Port is needed
+ *
+ * @param pool Frame Pool, to which Frames are released after the Notifications
+ * @param port UDP Port of the CoAP Server on the Sensor
+ * @param notifyFd eventfd, which is incremented for submitted Frames (set_frame_notify_fd()), -1 --> not used
+ * @return coap_audio_t* Pointer to Observe Resource // NULL if Init failed
+ */
+coap_audio_t *init_coap_audio(frame_pool_handle_t *pool, uint16_t port, int notifyFd);
+
+/**
+ * @brief Make frame the current Representation of /audio and mark the Resource dirty. The Notifications are build in
+ * the next coap_audio_process(), every Observer gets the Frame Data without an extra Copy per Frame
+ *
+ * @param audio Pointer to Observe Resource
+ * @param frame Frame to publish, gets an additional Reference until the next Frame is published
+ * @return 0 if there is no Observer // 1 if Observers will be notified
+ */
+int coap_audio_publish(coap_audio_t *audio, frame_t *frame);
+
+/**
+ * @brief I/O Loop Step: send Notifications, handle Registrations, Deregistrations, RSTs and Block2 Requests. Waits until
+ * Traffic arrives, a libcoap Timer expires, a Frame is submitted or timeout_ms is over
+ *
+ * @param audio Pointer to Observe Resource
+ * @param timeout_ms Maximum Time to wait, COAP_IO_NO_WAIT --> return at once
+ */
+void coap_audio_process(coap_audio_t *audio, uint32_t timeout_ms);
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file coap_control.h
+ * @brief CoAP Resources for Configuration and Control of the Sensor: /config/rate, /config/codec, /control/start, /stats
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __COAP_CONTROL_H__
+#define __COAP_CONTROL_H__
+
+#include <sys/select.h>
+#include "lwip/sockets.h"
+#include "coap3/coap.h"
+#include "frame_pool.h"
+#include "bitrate.h"
+
+#define COAP_CONTROL_VALUE_SIZE 16  // Longest Text Value of a PUT
+#define COAP_CONTROL_GROUP "224.0.1.187"    // All-CoAP-Nodes (RFC 7252), Target of the Discovery
+#define COAP_CONTROL_RESOURCE_TYPE "\"audio-sensor\""  // rt of /config/enroll, Collectors filter with ?rt=audio-sensor
+
+/**
+ * @brief Counters of the Control Resources, only read for Logging
+ *
+ */
+struct coap_control_stats{
+    uint32_t requests;      // Requests on all Resources
+    uint32_t changed;       // PUT/POST which changed a Setting
+    uint32_t rejected;      // Requests with invalid Value (4.00)
+    uint32_t enrollments;   // PUT /config/enroll which changed SensorID or Server
+};
+typedef struct coap_control_stats coap_control_stats_t;
+
+/**
+ * @brief Struct and Typedef for the Control Resources. Served by the Network-Task, libcoap is not thread-safe
+ *
+ */
+struct coap_control{
+    coap_context_t *context;
+    coap_resource_t *stats;     // Observable /stats
+    frame_pool_handle_t *pool;
+    bitrate_handle_t *bitrate;
+    uint32_t sensorRate;    // Sample Rate of the Sensor in Hz, /config/rate is sensorRate / decimation
+    void (*start)(void);    // Starts the Measurement, called again for repeated Requests
+    void (*enroll)(uint8_t sensorID, const struct sockaddr_in *server);   // NULL --> Discovery disabled
+    uint8_t sensorID;           // Last Enrollment
+    struct sockaddr_in server;  // Last Enrollment
+    coap_control_stats_t counters;
+};
+typedef struct coap_control coap_control_t;
+
+/**
+ * @brief Initialize libcoap as Server on port with the Control Resources. All Requests are idempotent, so the Server can
+ * send them as CON to many Sensors in parallel and repeat them
+ *
+ * @param port UDP Port of the CoAP Server on the Sensor
+ * @param pool Frame Pool, its Counters are shown in /stats
+ * @param bitrate Bitrate Controller, /config/rate and /config/codec select its Profile
+ * @param sensorRate Sample Rate of the Sensor in Hz
+ * @param start Function which starts the Measurement
+ * @return coap_control_t* Pointer to Control Resources // NULL if Init failed
+ */
+coap_control_t *init_coap_control(uint16_t port, frame_pool_handle_t *pool, bitrate_handle_t *bitrate,
+                                  uint32_t sensorRate, void (*start)(void));
+
+/**
+ * @brief Join the All-CoAP-Nodes Group and add /config/enroll, so a Collector finds the Sensor with a Multicast
+ * GET /.well-known/core?rt=audio-sensor and enrolls it with a unicast CON PUT "<SensorID> <Data-Port>". The Sender of
+ * the PUT becomes the Server, it replaces the Register Round Trip to LOCALHOST_ADDRESS
+ *
+ * @param control Pointer to Control Resources
+ * @param enroll Called with SensorID and Server Address (Data-Port) of every Enrollment which changes them
+ * @return -1 if the Group can not be joined // 1 if Discovery is active
+ */
+int coap_control_discovery(coap_control_t *control, void (*enroll)(uint8_t sensorID, const struct sockaddr_in *server));
+
+/**
+ * @brief I/O Loop Step of the Network-Task: one select() over the libcoap Socket and the Sockets in readfds, then
+ * Requests are handled
+ *
+ * @param control Pointer to Control Resources
+ * @param timeout_ms Maximum Time to wait, at least 1
+ * @param nfds Highest File Descriptor in readfds + 1
+ * @param readfds Sockets of the Caller, only the readable ones are set on Return, NULL --> only libcoap Sockets
+ * @return -1 if select failed // 1 if readfds is valid
+ */
+int coap_control_process(coap_control_t *control, uint32_t timeout_ms, int nfds, fd_set *readfds);
+
+/**
+ * @brief Notify Observers of /stats, e.g. after the Counters were logged
+ *
+ * @param control Pointer to Control Resources
+ */
+void coap_control_stats_changed(coap_control_t *control);
+
+#endif
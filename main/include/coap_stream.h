@@ -0,0 +1,129 @@
+/**
+ * @file coap_stream.h
+ * @brief Transport of Frames as CoAP POST with libcoap Large-Body Support (Block1 / Q-Block1), one Request per Frame
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __COAP_STREAM_H__
+#define __COAP_STREAM_H__
+
+#include "coap3/coap.h"
+#include "frame_pool.h"
+
+#define COAP_STREAM_NSTART 4        // Block Transfers at the same time (NSTART), further Frames wait in the Transmit Queue
+#define COAP_STREAM_PROBING_RATE 4000   // Bytes/s while the Server does not respond (RFC 7252 PROBING_RATE)
+#define COAP_STREAM_SILENCE_US 2000000  // Server counts as not responding after this Time without a Response
+#define COAP_STREAM_PDU_POOL_SIZE 4 // Preformatted PDUs for Frames which fit into one PDU
+#define COAP_STREAM_CSM_MAX_MESSAGE_SIZE 16384  // Max-Message-Size in the CSM of TCP/WebSocket Sessions, > 1 Frame
+#define COAP_STREAM_PSK_NAMESPACE "coap"    // NVS Namespace with the DTLS PSK: "psk_id" (String) and "psk_key" (Blob)
+#define COAP_STREAM_PSK_MAX_LENGTH 64
+#define COAP_STREAM_OSCORE_MAX_CONF 512     // OSCORE Configuration (libcoap Text Format) in NVS: "oscore_conf" (String)
+#define COAP_STREAM_OSCORE_SSN_FREQ 1000    // Sender Sequence Numbers between two NVS Writes of "oscore_ssn"
+#define COAP_STREAM_OSCORE_OVERHEAD 24      // OSCORE Option, inner Code and AEAD Tag in a protected single-PDU Frame
+
+/**
+ * @brief Counters of the CoAP Transport, only read for Logging
+ *
+ */
+struct coap_stream_stats{
+    uint32_t requests;      // Frames handed to libcoap
+    uint32_t blockwise;     // Frames which needed a Block Transfer, 0 with a large enough CSM Max-Message-Size
+    uint32_t responses;     // Final Responses with Success Code
+    uint32_t errors;        // Error Responses and NACKs (Timeout, Reset, ...)
+    uint32_t released;      // Frames libcoap is done with
+    uint32_t pduPoolMisses; // Single-PDU Frames which had to format a PDU while sending
+    uint32_t sendFailed;    // Frames libcoap refused (PDU, Block Setup or coap_send failed)
+    uint32_t nstartLimited; // Times a Frame waited because NSTART Transfers were running
+    uint32_t probingLimited;    // Times a Frame waited for the Probing Rate
+    uint inFlightHighWater; // Maximum Block Transfers at the same time
+    uint32_t sends;         // coap_send() Calls, including DTLS Record Encryption
+    uint64_t sendUs;        // Time in coap_send() over all Calls
+    uint32_t sendMaxUs;
+    uint32_t handshakes;    // Established DTLS Sessions, the first one and Reconnects
+    uint32_t handshakeUs;   // Session Setup until DTLS established, of the last Handshake
+    uint32_t reconnects;    // Sessions replaced after a DTLS Error or Close
+};
+typedef struct coap_stream_stats coap_stream_stats_t;
+
+/**
+ * @brief PDU with Token, Options and reserved Payload already encoded. Only Message ID and Payload are written when sending
+ *
+ */
+struct coap_stream_pdu{
+    coap_pdu_t *pdu;
+    uint8_t *payload;       // Reserved Payload Area inside the PDU Buffer
+    size_t length;          // Size of the Payload Area
+};
+
+/**
+ * @brief Struct and Typedef for CoAP Stream. All Calls have to come from the same Task, libcoap is not thread-safe
+ *
+ */
+struct coap_stream{
+    coap_context_t *context;
+    coap_session_t *session;
+    coap_proto_t proto;     // COAP_PROTO_UDP, COAP_PROTO_TCP, COAP_PROTO_WS or COAP_PROTO_DTLS
+    coap_address_t server;
+    frame_pool_handle_t *pool;
+    uint inFlight;          // Frames referenced by libcoap until the release Callback
+    int notifyFd;           // eventfd of the Frame Pool, wakes up the I/O Loop for new Frames
+    uint8_t pskIdentity[COAP_STREAM_PSK_MAX_LENGTH];
+    size_t pskIdentityLength;
+    uint8_t pskKey[COAP_STREAM_PSK_MAX_LENGTH];
+    size_t pskKeyLength;
+    int64_t sessionStart;   // esp_timer Time the Session was created, for the Handshake Time
+    bool reconnect;         // DTLS Session failed, a new one (resuming the last DTLS Session) is created
+    char *oscoreConf;       // OSCORE Configuration from NVS, NULL --> Requests are not protected by OSCORE
+    uint64_t oscoreSsn;     // Sender Sequence Number a new OSCORE Context starts with (saved in NVS)
+    int64_t lastResponse;   // esp_timer Time of the last Response, Start of the Stream before the first one
+    int64_t lastCredit;     // esp_timer Time of the last Probing Credit Update
+    uint32_t credit;        // Bytes which may be send while the Server does not respond
+    uint8_t contentType[2]; // Content-Format Option Value, encoded once
+    size_t contentTypeLength;
+    struct coap_stream_pdu pdus[COAP_STREAM_PDU_POOL_SIZE];
+    uint pduCount;          // Preformatted PDUs in pdus
+    size_t pduLength;       // Payload Size the Pool is formatted for, Size of the last single-PDU Frame
+    coap_stream_stats_t stats;
+};
+typedef struct coap_stream coap_stream_t;
+
+/**
+ * @brief Initialize libcoap with Block Mode (Q-Block1 if the Server supports it), NSTART and Probing Rate and create the
+ * Client Session. Over TCP and WebSocket the Session waits for the CSM of the Server, with a Max-Message-Size above the
+ * Frame Size whole Frames go out as single Messages without Blocks. COAP_PROTO_DTLS uses the PSK from NVS
+ * (COAP_STREAM_PSK_NAMESPACE), a failed DTLS Session is replaced and resumes the last DTLS Session. With oscore the
+ * Requests are protected end-to-end by OSCORE, Keys are derived once per Session, each Frame only pays the AEAD
+ *
+ * @param pool Frame Pool, to which Frames are released after Transmission
+ * @param server Address and Port of the CoAP Server
+ * @param proto COAP_PROTO_UDP, COAP_PROTO_TCP, COAP_PROTO_WS or COAP_PROTO_DTLS
+ * @param oscore TRUE --> OSCORE with the Configuration from NVS (COAP_STREAM_PSK_NAMESPACE, "oscore_conf")
+ * @param notifyFd eventfd, which is incremented for submitted Frames (set_frame_notify_fd()), -1 --> not used
+ * @return coap_stream_t* Pointer to CoAP Stream // NULL if Init failed
+ */
+coap_stream_t *init_coap_stream(frame_pool_handle_t *pool, const struct sockaddr_in *server, coap_proto_t proto,
+                                bool oscore, int notifyFd);
+
+/**
+ * @brief Send a Frame as one NON POST. A Frame which fits into one PDU is copied once into the Payload Area of a
+ * preformatted PDU. Larger Frames are split by libcoap into MTU-sized Blocks, missing Blocks are recovered. Their Data
+ * is not copied, the Frame gets an additional Reference until libcoap releases it
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param frame Frame to send
+ * @return -1 if send failed // 0 if NSTART or the Probing Rate holds the Frame back, try again later // 1 if send successfull
+ */
+int coap_stream_send_frame(coap_stream_t *stream, frame_t *frame);
+
+/**
+ * @brief I/O Loop Step: let libcoap send pending Blocks, handle Responses, RSTs, Timeouts and Retransmissions. Waits
+ * until Traffic arrives, a libcoap Timer expires, a Frame is submitted or timeout_ms is over. Refills the PDU Pool
+ *
+ * @param stream Pointer to CoAP Stream
+ * @param timeout_ms Maximum Time to wait, COAP_IO_NO_WAIT --> return at once
+ */
+void coap_stream_process(coap_stream_t *stream, uint32_t timeout_ms);
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * @file control.h
+ * @brief Commands received from the Server on the Settings-Socket. First Byte of every Message is the Command
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __CONTROL_H__
+#define __CONTROL_H__
+
+#define CONTROL_MESSAGE_SIZE 256
+#define CONTROL_TIME_SYNC_REPLY_SIZE 17
+
+/**
+ * @brief Command Byte of a Settings Message
+ *
+ */
+enum control_command{
+    CONTROL_START = 1,  // Start Measurement, Broadcast from Server
+    CONTROL_NACK = 2,   // Followed by Pairs of uint32_t first/last missing Sequence Number in NBO
+    CONTROL_ADD_DESTINATION = 3,    // Followed by IPv4 Address and Port in NBO (6 Bytes)
+    CONTROL_REMOVE_DESTINATION = 4, // Followed by IPv4 Address and Port in NBO (6 Bytes)
+    CONTROL_TIME_SYNC = 5,  // Followed by uint32_t Token. Reply: Token, tv_sec, tv_usec, us since Start (uint32_t, NBO)
+    CONTROL_FEEDBACK = 6,   // Receiver Report: uint16_t Loss in Permille, uint32_t Jitter in us, uint32_t Throughput in kbit/s (NBO)
+    CONTROL_FRAME_MODE = 7, // Followed by one Byte frame_mode_t (frame_mode.h)
+};
+typedef enum control_command control_command_t;
+
+#endif
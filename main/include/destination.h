@@ -0,0 +1,104 @@
+/**
+ * @file destination.h
+ * @brief List of Receivers (Unicast or Multicast Group) for the same Frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __DESTINATION_H__
+#define __DESTINATION_H__
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+
+#define DESTINATION_MAX 4
+
+/**
+ * @brief Counters of one Receiver, reset when the Receiver is added
+ *
+ */
+struct destination_stats{
+    uint32_t sent;      // Frames handed to the Socket for this Receiver
+    uint32_t failed;    // Frames this Receiver did not get, while other Receivers did
+};
+typedef struct destination_stats destination_stats_t;
+
+/**
+ * @brief Struct and Typedef for Destination List. Changed by Control-Task, read by Send-Task
+ *
+ */
+struct destination_list{
+    struct sockaddr_in addr[DESTINATION_MAX];
+    destination_stats_t stats[DESTINATION_MAX];
+    uint count;
+    SemaphoreHandle_t mutex;
+};
+typedef struct destination_list destination_list_t;
+
+/**
+ * @brief Initialize empty Destination List
+ *
+ * @return destination_list_t* Pointer to Destination List // NULL if allocation failed
+ */
+destination_list_t *init_destinations(void);
+
+/**
+ * @brief Add a Receiver to the List
+ *
+ * @param list Pointer to Destination List
+ * @param addr IPv4 Address and Port of the Receiver
+ * @return -1 if List is full // 0 if Receiver is already in List // 1 if added
+ */
+int add_destination(destination_list_t *list, const struct sockaddr_in *addr);
+
+/**
+ * @brief Remove a Receiver from the List
+ *
+ * @param list Pointer to Destination List
+ * @param addr IPv4 Address and Port of the Receiver
+ * @return -1 if Receiver was not in List // 1 if removed
+ */
+int remove_destination(destination_list_t *list, const struct sockaddr_in *addr);
+
+/**
+ * @brief Copy the List, so the Send-Task does not hold the Mutex while sending
+ *
+ * @param list Pointer to Destination List
+ * @param addr Array with DESTINATION_MAX Elements
+ * @return uint Number of copied Receivers
+ */
+uint copy_destinations(destination_list_t *list, struct sockaddr_in *addr);
+
+/**
+ * @brief Find the Receiver with the given IP, e.g. the Sender of a NACK
+ *
+ * @param list Pointer to Destination List
+ * @param ip IPv4 Address to search for
+ * @param addr Found Address and Port
+ * @return -1 if not found // 1 if found
+ */
+int find_destination(destination_list_t *list, struct in_addr ip, struct sockaddr_in *addr);
+
+/**
+ * @brief Count a Frame for a Receiver, Receivers removed in the meantime are ignored
+ *
+ * @param list Pointer to Destination List
+ * @param addr IPv4 Address and Port of the Receiver
+ * @param sent true if the Receiver got the Frame // false if the Send failed
+ */
+void count_destination(destination_list_t *list, const struct sockaddr_in *addr, bool sent);
+
+/**
+ * @brief Copy the List with the Counters of every Receiver, for Logging
+ *
+ * @param list Pointer to Destination List
+ * @param addr Array with DESTINATION_MAX Elements
+ * @param stats Array with DESTINATION_MAX Elements
+ * @return uint Number of copied Receivers
+ */
+uint copy_destination_stats(destination_list_t *list, struct sockaddr_in *addr, destination_stats_t *stats);
+
+#endif
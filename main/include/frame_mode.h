@@ -0,0 +1,47 @@
+/**
+ * @file frame_mode.h
+ * @brief Frame Sizing Modes: small Frames for low Latency or large, batched Frames for Throughput. Switchable at Runtime
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __FRAME_MODE_H__
+#define __FRAME_MODE_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Frame Sizing Mode, also the Value of the Mode Byte in CONTROL_FRAME_MODE
+ *
+ */
+enum frame_mode{
+    FRAME_MODE_THROUGHPUT = 0,  // Full Ringbuffers, two Blocks per Frame, Frames are send in Batches
+    FRAME_MODE_LATENCY = 1,     // Few ms of Samples, one Block with one Header per Frame, send at once
+    FRAME_MODE_COUNT,
+};
+typedef enum frame_mode frame_mode_t;
+
+/**
+ * @brief Frame Layout and Send Behaviour of a Mode
+ *
+ */
+struct frame_mode_profile{
+    uint blockSize;         // Samples per Ringbuffer Block, at most the allocated Ringbuffer Size
+    uint blocksPerFrame;    // Blocks (Header + Samples) in one Frame
+    uint batch;             // Queued Frames before the Send-Loop starts a Burst
+};
+typedef struct frame_mode_profile frame_mode_profile_t;
+
+/**
+ * @brief Capture-to-Send Latency of one Mode, from the first Sample of a Frame until the Frame is handed to lwIP
+ *
+ */
+struct frame_latency{
+    uint32_t frames;
+    uint64_t sumUs;
+    uint32_t maxUs;
+};
+typedef struct frame_latency frame_latency_t;
+
+#endif
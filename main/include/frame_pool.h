@@ -0,0 +1,153 @@
+/**
+ * @file frame_pool.h
+ * @brief Preallocated Frame Pool and lock-free Transmit Queue between Collect-Task and Send-Task
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __FRAME_POOL_H__
+#define __FRAME_POOL_H__
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+
+/**
+ * @brief What to do with a Frame, when the Pool is empty because the Link can not keep up
+ *
+ */
+enum frame_drop_policy{
+    FRAME_DROP_OLDEST,  // Discard the oldest queued Frame and reuse it for the new Data
+    FRAME_DROP_NEWEST,  // Keep the queued Frames and discard the new Data
+};
+typedef enum frame_drop_policy frame_drop_policy_t;
+
+/**
+ * @brief Struct and Typedef for one Frame. The Collect-Task appends raw Blocks in Host Byte Order, the Encode-Stage on
+ * the Network Core converts them to Network Byte Order before the Frame is sent
+ *
+ */
+struct frame{
+    uint32_t *data;
+    uint length;    // Used Words in data
+    uint size;      // Capacity of data in Words
+    uint32_t seq;   // Sequence Number, also first Word of data
+    int64_t captureTime;    // Time of the first Sample in us since Epoch (gettimeofday), for the Capture-to-Send Latency
+    uint8_t mode;           // frame_mode_t the Frame was built with
+    uint8_t rawBlocks;      // Blocks (SensorID, Timestamp, Samples) at the End of data not encoded yet
+    uint16_t rawSamples;    // Samples per raw Block before Decimation
+    uint8_t decimation;     // Profile of the raw Blocks: every n-th Sample is kept
+    uint8_t sampleBits;     // Profile of the raw Blocks: 32 or 16 (two Samples per Word)
+    atomic_uint refs;       // Owner (Queue/History) plus Datagrams still in lwIP/WiFi
+};
+typedef struct frame frame_t;
+
+/**
+ * @brief Counters of the Frame Pool. Written by Collect- and Send-Task on different Cores and read by Logging and
+ * CoAP Tasks, so every Counter is atomic
+ *
+ */
+struct frame_pool_stats{
+    _Atomic(uint32_t) captured;         // Frames filled by the Collect-Task
+    _Atomic(uint32_t) sent;             // Frames handed to the Socket successfully
+    _Atomic(uint64_t) bytesSent;        // Payload Bytes of sent Frames, for Throughput
+    _Atomic(uint32_t) droppedOldest;    // Queued Frames discarded by FRAME_DROP_OLDEST
+    _Atomic(uint32_t) droppedNewest;    // New Frames discarded by FRAME_DROP_NEWEST
+    _Atomic(uint32_t) sendFailed;       // Frames discarded after all Send-Retries failed
+    _Atomic(uint32_t) sendRetries;      // Send-Retries because lwIP/WiFi was out of Buffers
+    _Atomic(uint32_t) queueHighWater;   // Maximum Frames waiting in Transmit Queue
+};
+typedef struct frame_pool_stats frame_pool_stats_t;
+
+/**
+ * @brief Struct and Typedef for Frame Pool. The Transmit Queue is a lock-free Ring: only the Collect-Task pushes,
+ * the Send-Task pops and the Collect-Task may pop the oldest Frame for FRAME_DROP_OLDEST, so tail is advanced with CAS
+ *
+ */
+struct frame_pool_handle{
+    frame_t *frames;
+    uint count;
+    QueueHandle_t freeQueue;    // Released from several Tasks (Send-Task, lwIP/WiFi), stays a FreeRTOS Queue
+    _Atomic(frame_t *) *txRing;
+    uint txRingMask;            // Ring Size - 1, Ring Size is a Power of 2 >= count
+    atomic_uint txHead;
+    atomic_uint txTail;
+    TaskHandle_t consumer;      // Send-Task, notified when a Frame is submitted
+    int notifyFd;               // eventfd for select() based Send-Loops, -1 --> Task Notification
+    frame_drop_policy_t policy;
+    frame_pool_stats_t stats;
+};
+typedef struct frame_pool_handle frame_pool_handle_t;
+
+/**
+ * @brief Initialize and allocate all Frames of the Pool. No Memory will be allocated after this Call
+ *
+ * @param count Number of Frames in the Pool
+ * @param size Size of every Frame in Words (uint32_t)
+ * @param policy Drop Policy if no free Frame is left
+ * @return frame_pool_handle_t* Pointer to Frame Pool // NULL if allocation failed
+ */
+frame_pool_handle_t *init_frame_pool(uint count, uint size, frame_drop_policy_t policy);
+
+/**
+ * @brief Get an empty Frame from the Pool. Waits up to wait Ticks for the Send-Task to return a Frame (Backpressure),
+ * then applies the Drop Policy
+ *
+ * @param pool Pointer to Frame Pool
+ * @param wait Ticks to wait for a free Frame
+ * @return frame_t* Empty Frame // NULL if the new Data should be dropped
+ */
+frame_t *get_free_frame(frame_pool_handle_t *pool, TickType_t wait);
+
+/**
+ * @brief Put a filled Frame into the Transmit Queue
+ *
+ * @param pool Pointer to Frame Pool
+ * @param frame Filled Frame
+ */
+void submit_frame(frame_pool_handle_t *pool, frame_t *frame);
+
+/**
+ * @brief Take the oldest Frame out of the Transmit Queue. The calling Task gets notified about new Frames
+ *
+ * @param pool Pointer to Frame Pool
+ * @param wait Ticks to wait for a Frame
+ * @return frame_t* Frame to send // NULL if Queue was empty
+ */
+frame_t *receive_frame(frame_pool_handle_t *pool, TickType_t wait);
+
+/**
+ * @brief Signal submitted Frames on an eventfd instead of a Task Notification, so the Send-Loop can wait in select()
+ *
+ * @param pool Pointer to Frame Pool
+ * @param fd eventfd, which gets incremented for every submitted Frame
+ */
+void set_frame_notify_fd(frame_pool_handle_t *pool, int fd);
+
+/**
+ * @brief Take an additional Reference, e.g. for a Datagram which points to the Frame Data
+ *
+ * @param frame Frame to hold
+ */
+void hold_frame(frame_t *frame);
+
+/**
+ * @brief Drop one Reference. The Frame goes back to the Pool when the last Reference is released. Safe to call from
+ * the lwIP/WiFi Task
+ *
+ * @param pool Pointer to Frame Pool
+ * @param frame Frame to release
+ */
+void release_frame(frame_pool_handle_t *pool, frame_t *frame);
+
+/**
+ * @brief Number of Frames currently waiting in the Transmit Queue
+ *
+ * @param pool Pointer to Frame Pool
+ * @return uint Queued Frames
+ */
+uint queued_frames(frame_pool_handle_t *pool);
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file pipeline.h
+ * @brief Core Assignment, Priorities and CPU Load Measurement of the Pipeline Stages
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "esp_cpu.h"
+#include "frame_pool.h"
+
+// Acquisition (Timer-ISR) and Collect-Task on one Core, Encoding and Networking next to WiFi/lwIP on the other
+#define PIPELINE_ACQUISITION_CORE 1
+#define PIPELINE_NETWORK_CORE 0
+
+#define PIPELINE_COLLECT_PRIORITY 10
+#define PIPELINE_SEND_PRIORITY 5
+
+/**
+ * @brief Stages of the Pipeline with separate CPU Load
+ *
+ */
+enum pipeline_stage{
+    STAGE_ACQUISITION,  // Timer-ISR writing the Ringbuffers
+    STAGE_COLLECT,      // Ringbuffer to Frame
+    STAGE_ENCODE,       // Decimation, Sample Packing and Byte Order of a Frame
+    STAGE_SEND,         // Frame to Socket/lwIP
+    STAGE_CONTROL,      // Settings- and Register-Socket
+    STAGE_COUNT,
+};
+typedef enum pipeline_stage pipeline_stage_t;
+
+/**
+ * @brief Busy CPU Cycles per Stage. Every Stage is written by one Core only, uint32_t wraps and is read as Difference
+ *
+ */
+struct pipeline_stats{
+    volatile uint32_t busyCycles[STAGE_COUNT];
+    volatile int core[STAGE_COUNT];
+};
+typedef struct pipeline_stats pipeline_stats_t;
+
+extern pipeline_stats_t pipeline_stats;
+
+/**
+ * @brief Start of a busy Section. Cheap enough for the Timer-ISR
+ *
+ * @return uint32_t CPU Cycle Counter
+ */
+static inline uint32_t pipeline_begin(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+/**
+ * @brief End of a busy Section, adds the Cycles to the Stage
+ *
+ * @param stage Stage which was busy
+ * @param start Return Value of pipeline_begin()
+ */
+static inline void pipeline_end(pipeline_stage_t stage, uint32_t start)
+{
+    pipeline_stats.busyCycles[stage] += esp_cpu_get_cycle_count() - start;
+    pipeline_stats.core[stage] = esp_cpu_get_core_id();
+}
+
+/**
+ * @brief Encode-Stage: decimates and packs the raw Blocks of a Frame in place and converts them to Network Byte Order.
+ * Called by the Send-Tasks, so the Work runs on PIPELINE_NETWORK_CORE. Encoded Frames are left unchanged
+ *
+ * @param frame Frame from the Transmit Queue
+ */
+void encode_frame(frame_t *frame);
+
+/**
+ * @brief Print CPU Load of every Stage since the last Call to Log
+ *
+ */
+void log_pipeline_load(void);
+
+#endif
@@ -22,6 +22,7 @@ struct ringbuffer_handle{
     struct timeval timestamp;
     uint32_t *sensValue;
     int size;
+    int capacity;   // Allocated Values, size can be reduced up to this at Runtime
     bool full;
 };
 typedef struct ringbuffer_handle ringbuffer_handle_t;
@@ -67,6 +68,15 @@ uint32_t read_from_buffer(ringbuffer_handle_t *buffer);
  */
 bool is_full(ringbuffer_handle_t *buffer);
 
+/**
+ * @brief Change the used Size of an empty Buffer. Mutex has to be taken by Caller, so the Write-Task does not fill it meanwhile
+ * 
+ * @param buffer Pointer to Buffer which should be resized
+ * @param size New Size, at most the Size given to init_buffer()
+ * @return -1 if Size is too large or Buffer is not empty // 1 if resized
+ */
+int set_buffer_size(ringbuffer_handle_t *buffer, uint size);
+
 /**
  * @brief Free Ringbuffer
  * 
@@ -0,0 +1,72 @@
+/**
+ * @file tcp_stream.h
+ * @brief Lossless Transport of Frames over a persistent TCP Connection with length-prefixed Frames
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __TCP_STREAM_H__
+#define __TCP_STREAM_H__
+
+#include "lwip/sockets.h"
+#include "frame_pool.h"
+
+#define TCP_STALL_TIMEOUT_MS 200    // A Send blocked or unacknowledged Frames without Ack longer than this --> dead Connection
+#define TCP_CONNECT_TIMEOUT_MS 200  // A Connect taking longer than this fails
+
+/**
+ * @brief Struct and Typedef for TCP Stream. The Server acknowledges received Frames with their Sequence Number (uint32_t, NBO)
+ *
+ */
+struct tcp_stream{
+    int sock;               // -1 while disconnected
+    struct sockaddr_in addr;
+    uint32_t lastAcked;     // Last Sequence Number acknowledged by the Server, UINT32_MAX before the first Frame
+    uint8_t ackBuffer[sizeof(uint32_t)];
+    uint ackBytes;
+    uint32_t reconnects;
+};
+typedef struct tcp_stream tcp_stream_t;
+
+/**
+ * @brief Initialize TCP Stream without connecting
+ *
+ * @param addr IPv4 Address and Port of the Server
+ * @return tcp_stream_t* Pointer to TCP Stream // NULL if allocation failed
+ */
+tcp_stream_t *init_tcp_stream(const struct sockaddr_in *addr);
+
+/**
+ * @brief Connect to the Server with Nagle disabled, Keepalive and Send-Timeout. Waits at most TCP_CONNECT_TIMEOUT_MS
+ *
+ * @param stream Pointer to TCP Stream
+ * @return -1 if connect failed // 1 if connected
+ */
+int tcp_stream_connect(tcp_stream_t *stream);
+
+/**
+ * @brief Close the Connection, the next Frame will trigger a Reconnect
+ *
+ * @param stream Pointer to TCP Stream
+ */
+void tcp_stream_close(tcp_stream_t *stream);
+
+/**
+ * @brief Send a Frame with its Length in Bytes (uint32_t, NBO) in front. Blocks while the TCP Send Buffer is full
+ *
+ * @param stream Pointer to TCP Stream
+ * @param frame Frame to send
+ * @return -1 if Connection failed // 1 if send successfull
+ */
+int tcp_stream_send_frame(tcp_stream_t *stream, frame_t *frame);
+
+/**
+ * @brief Read all pending Acknowledgements without blocking and update lastAcked
+ *
+ * @param stream Pointer to TCP Stream
+ * @return -1 if Connection was closed by Server // 1 else
+ */
+int tcp_stream_poll_ack(tcp_stream_t *stream);
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file udp_raw.h
+ * @brief Zero-Copy UDP Sender with the lwIP raw API. Datagrams reference the Frame Data (PBUF_REF) instead of copying it
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef __UDP_RAW_H__
+#define __UDP_RAW_H__
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "lwip/sockets.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "frame_pool.h"
+
+#define UDP_RAW_PBUF_COUNT 16   // Datagrams in lwIP/WiFi at the same time
+
+struct udp_raw;
+
+/**
+ * @brief Custom pbuf pointing to a Frame. Holds a Reference of the Frame until lwIP/WiFi free the pbuf
+ *
+ */
+struct udp_raw_pbuf{
+    struct pbuf_custom custom;  // has to be first, lwIP casts the pbuf back
+    frame_t *frame;
+    struct udp_raw *raw;
+};
+
+/**
+ * @brief Struct and Typedef for raw UDP Sender
+ *
+ */
+struct udp_raw{
+    struct udp_pcb *pcb;
+    frame_pool_handle_t *pool;
+    struct udp_raw_pbuf pbufs[UDP_RAW_PBUF_COUNT];
+    QueueHandle_t freePbufs;
+    uint32_t pbufsExhausted;    // Sends postponed because every pbuf was in flight
+};
+typedef struct udp_raw udp_raw_t;
+
+/**
+ * @brief Initialize raw UDP Sender. Needs CONFIG_LWIP_TCPIP_CORE_LOCKING, so lwIP can be called without the tcpip Mailbox
+ *
+ * @param pool Frame Pool, to which Frames are released after Transmission
+ * @param ttl TTL for Multicast Destinations
+ * @return udp_raw_t* Pointer to raw UDP Sender // NULL if Init failed
+ */
+udp_raw_t *init_udp_raw(frame_pool_handle_t *pool, uint8_t ttl);
+
+/**
+ * @brief Send a Frame as one Datagram without copying the Frame Data
+ *
+ * @param raw Pointer to raw UDP Sender
+ * @param frame Frame to send, gets an additional Reference until the Datagram is transmitted
+ * @param addr IPv4 Address and Port of the Receiver
+ * @return -1 if send failed // 0 if lwIP/WiFi is out of Buffers, try again later // 1 if send successfull
+ */
+int udp_raw_send_frame(udp_raw_t *raw, frame_t *frame, const struct sockaddr_in *addr);
+
+#endif
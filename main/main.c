@@ -22,7 +22,9 @@
 #include "esp_netif.h"
 #include "esp_system.h"
 #include <sys/socket.h>
-#include "coap3/coap.h"
+#include <sys/select.h>
+#include <fcntl.h>
+#include "esp_vfs_eventfd.h"
 #include "lwip/sockets.h"
 #include "driver/gptimer.h"
 #include "esp_netif_sntp.h"
@@ -33,18 +35,69 @@
 #include "wifi_setting.h"
 #include "led_setting.h"
 #include "ringbuffer.h"
+#include "frame_pool.h"
+#include "arq.h"
+#include "destination.h"
+#include "tcp_stream.h"
+#include "udp_raw.h"
+#include "coap_stream.h"
+#include "coap_audio.h"
+#include "coap_control.h"
+#include "pipeline.h"
+#include "control.h"
+#include "bitrate.h"
+#include "frame_mode.h"
 //#include "http_client.h"
 
 // Global Defines
 #define RINGBUFFER_SIZE 1250
-#define SENSOR_RATE (1000000/44000) // Frequency 44kHz --> ~23 us
+#define FRAME_SIZE ((RINGBUFFER_SIZE * 2) + 5) // 2 Ringbuffers +2 for timestamps +2 for SensorID +1 for Sequence Number
+#define FRAME_MODE_DEFAULT FRAME_MODE_THROUGHPUT
+#define LATENCY_BLOCK_SIZE 125 // Samples per Frame in FRAME_MODE_LATENCY --> ~2.8 ms
+#define THROUGHPUT_BATCH 2 // Frames per Burst in FRAME_MODE_THROUGHPUT
+#define FRAME_SINGLE_BLOCK (1 << 25) // Flag in the first SensorID Word: Frame holds only one Block
+#define FRAME_POOL_SIZE (STREAM_TRANSPORT_TCP ? 14 : 10) // TCP: TCP_UNACKED_FRAMES + TCP_OUTAGE_FRAMES + 1, see below
+// Backpressure before the Drop Policy: half the Fill Time of one Block (Throughput ~14 ms --> 1 Tick), so the other
+// Ringbuffer can not overflow. Below one Tick (Latency ~1.4 ms) the Pool is polled without waiting
+#define FRAME_POOL_WAIT(mode) pdMS_TO_TICKS((frame_modes[mode].blockSize * SENSOR_RATE) / 2000)
+#define FRAME_DROP_POLICY FRAME_DROP_OLDEST
+#define SEND_INTERVAL_MS 0 // Minimum gap between two Datagrams, 0 --> limited by the Link only
+#define SEND_RETRY_MAX 5 // Retries (one per Tick) if lwIP/WiFi is out of Buffers
+#define UDP_RAW_SENDER 1 // 1 --> lwIP raw API without Payload Copy (udp_raw.c), 0 --> sendto() on sock
+#define STATS_INTERVAL_US 5000000
+#define TCP_RECONNECT_DELAY_MS 50
+#define STREAM_TRANSPORT_UDP (!STREAM_TRANSPORT_TCP && !STREAM_TRANSPORT_COAP && !STREAM_TRANSPORT_COAP_OBSERVE)
+#define COAP_STREAM_RETRY_MS 10 // I/O Loop Wait while a Frame is held back by NSTART or Probing Rate
+#define COAP_STREAM_IDLE_MS 100 // I/O Loop Wait without Frames, libcoap Timers and new Frames end it earlier
+#define COAP_POOL_STATS_MAX 12 // Size Classes of the libcoap Pools logged with the Frame Stats
+#define NET_IDLE_TIMEOUT_US 100000 // select() Timeout without pending Work
+#define NET_START_BIT BIT0
+#define FRAME_SEQUENCE (ARQ_ENABLE || STREAM_TRANSPORT_TCP) // Sequence Number Word in front of the Frame, NACKs and TCP Acks refer to it
+#define ARQ_HISTORY_SIZE 4 // Sent Frames kept for Retransmission, taken from FRAME_POOL_SIZE
+#define ARQ_RATE 10 // Retransmissions per second
+#define ARQ_BURST 4
+#define TCP_UNACKED_FRAMES ARQ_HISTORY_SIZE // Sent Frames without Ack, pinned in the History for the Resume, then the Send-Task waits for Acks
+#define TCP_OUTAGE_MS (TCP_STALL_TIMEOUT_MS + TCP_RECONNECT_DELAY_MS + TCP_CONNECT_TIMEOUT_MS) // Broken Link until Resume, one Connect Attempt
+#define TCP_OUTAGE_FRAMES (((TCP_OUTAGE_MS * 1000) + THROUGHPUT_FRAME_US - 1) / THROUGHPUT_FRAME_US) // Frames captured meanwhile
+#define SENSOR_FREQUENCY 44000 // Samples per second
+#define SENSOR_RATE (1000000/SENSOR_FREQUENCY) // Frequency 44kHz --> ~23 us
+#define SENSOR_RATE_HZ (1000000 / SENSOR_RATE) // Sample Rate the Timer really runs at: 22 us --> 45454 Hz
+#define BITRATE_FULL_KBPS ((SENSOR_RATE_HZ * 32) / 1000) // Payload of Profile 0 with uint32_t Samples
 //#define SENSOR_RATE (1000000/4000) // -> 4kHz --> 250 us
+#define THROUGHPUT_FRAME_US (2 * RINGBUFFER_SIZE * SENSOR_RATE) // Capture Time of a Frame in FRAME_MODE_THROUGHPUT --> 55 ms
+
+// udp_raw sends a Frame as one pbuf, its Length is 16 Bit
+_Static_assert(FRAME_SIZE * sizeof(uint32_t) <= UINT16_MAX, "FRAME_SIZE does not fit into one Datagram");
+
+// A TCP Outage must not evict a Frame the Server has not acknowledged: the Pool holds the unacknowledged Frames, the
+// Frames captured until the Resume and the Frame being collected (FRAME_MODE_THROUGHPUT)
+_Static_assert(!STREAM_TRANSPORT_TCP || FRAME_POOL_SIZE >= TCP_UNACKED_FRAMES + TCP_OUTAGE_FRAMES + 1,
+               "FRAME_POOL_SIZE does not cover the TCP Resume Window");
 
 // ESP_LOG Tags
 const char *tag_ringbuffer1 = "ringbuffer1";
 const char *tag_ringbuffer2 = "ringbuffer2";
 const char *tag_socket = "Socket";
-const char *tag_coap = "CoAP-Client";
 const char *tag_sntp = "SNTP";
 const char *tag_debug = "Debug Info";
 
@@ -52,6 +105,10 @@ const char *tag_debug = "Debug Info";
 int lastBufferWritten = 2;
 uint32_t testVar = 0;
 
+// Sensor Timer, Callback is registered on PIPELINE_ACQUISITION_CORE
+gptimer_handle_t writetimer = NULL;
+TaskHandle_t collect_task_handle = NULL;
+
 // Stopwatch
 gptimer_handle_t stopwatchtimer = NULL;
 gptimer_config_t timer_config_stopwatch = {
@@ -74,17 +131,33 @@ socklen_t setting_addr_len = sizeof(setting_addr);
 socklen_t start_addr_len = sizeof(start_addr);
 uint8_t startMeasurement = 0;
 uint8_t sensorID;
-
-//CoAP Variables
-coap_context_t *coap_context;
-coap_session_t *coap_session;
-coap_address_t coap_address;
-coap_pdu_t *coap_message;
+uint8_t sensorEnrolled = 0;
+int frame_event_fd = -1;
+EventGroupHandle_t net_events;
 
 // Global Ringbuffers
 ringbuffer_handle_t *ringbuffer1;
 ringbuffer_handle_t *ringbuffer2;
 
+// Frames between Collect-Task and Send-Task
+frame_pool_handle_t *frame_pool;
+arq_handle_t *arq;
+destination_list_t *destinations;
+tcp_stream_t *tcp_stream;
+udp_raw_t *udp_raw;
+coap_stream_t *coap_stream;
+coap_audio_t *coap_audio;
+coap_control_t *coap_control;
+bitrate_handle_t *bitrate;
+
+// Frame Sizing, Mode is set by the Network-Task and applied by the Collect-Task at the next Frame
+static const frame_mode_profile_t frame_modes[FRAME_MODE_COUNT] = {
+    [FRAME_MODE_THROUGHPUT] = {.blockSize = RINGBUFFER_SIZE, .blocksPerFrame = 2, .batch = THROUGHPUT_BATCH},
+    [FRAME_MODE_LATENCY] = {.blockSize = LATENCY_BLOCK_SIZE, .blocksPerFrame = 1, .batch = 1},
+};
+volatile frame_mode_t frameMode = FRAME_MODE_DEFAULT;
+frame_latency_t frame_latency[FRAME_MODE_COUNT];
+
 // Mutexes for ringbuffer
 SemaphoreHandle_t ringbuffer1_mutex;
 SemaphoreHandle_t ringbuffer2_mutex;
@@ -97,8 +170,6 @@ time_t now;
 struct tm timeinfo = {0};
 struct timeval measuringStart;
 struct timeval measuringPoint;
-struct timeval beginnSend;
-struct timeval endSend;
 uint64_t time_elapsed;
 
 /**
@@ -110,7 +181,7 @@ void init_nvs(void);
 /**
  * @brief Check for free Buffer and write Sensordata to Buffer until buffer_full == true
  * 
- * @return Return Bool for yield a Function. Not relevant for this Software. Write Task has higher Prio then Send-Task
+ * @return true if a higher priority Task was woken (Mutex or Collect-Task Notification), the Timer yields at ISR exit
  */
 bool write_task(void);
 
@@ -122,25 +193,169 @@ bool write_task(void);
 int init_udp(void);
 
 /**
- * @brief Function to copy Ringbuffer to Array, convert to NBO and send to Local UDP-Server
+ * @brief Copy a full Ringbuffer with SensorID, Profile and Timestamp as raw Block in Host Byte Order to the end of a
+ * Frame. Decimation, Packing and Byte Order are left to the Encode-Stage on the Network Core
+ * 
+ * @param buffer Full Ringbuffer, Mutex has to be taken by Caller
+ * @param frame Frame to append to. NULL will read and discard the Ringbuffer
+ * @param profile Decimation and Sample Size of this Frame
+ */
+void copy_buffer_to_frame(ringbuffer_handle_t *buffer, frame_t *frame, const bitrate_profile_t *profile);
+
+/**
+ * @brief Take the next Frame from the Transmit Queue and encode it, the Send-Tasks call this on PIPELINE_NETWORK_CORE
+ * 
+ * @param wait Ticks to wait for a Frame
+ * @return frame_t* Encoded Frame // NULL if the Queue is empty
+ */
+frame_t *receive_encoded_frame(TickType_t wait);
+
+/**
+ * @brief Register the Timer-ISR on the calling Core and start the Sensor Timer
+ * 
+ */
+void start_write_timer(void);
+
+/**
+ * @brief Function to copy the Ringbuffer Blocks of the current Frame Mode into one Frame and put it into the Transmit
+ * Queue. Starts the Sensor Timer on its own Core first, so ISR and Collect-Task share PIPELINE_ACQUISITION_CORE
+ * 
+ * @param pvParameters NULL
+ */
+void collect_task(void *pvParameters);
+
+/**
+ * @brief Event Loop of the Network Core. Waits in select() on Settings-, Register- and Data-Socket, the CoAP Control Socket
+ * and on the Frame eventfd, so Control Traffic and Streaming never block each other. Sends Frames and Retransmissions over UDP without blocking
  * 
  * @param pvParameters NULL
  */
-void send_task_udp(void *pvParameters);
+void net_task(void *pvParameters);
+
+/**
+ * @brief Send all Frames from the Transmit Queue and the requested Retransmissions. Returns instead of waiting if
+ * lwIP/WiFi is out of Buffers, the Frame is kept in pending and send again in the next Loop
+ * 
+ * @param pending Frame which could not be send in the last Loop, NULL if none
+ * @param retries Retries of the pending Frame
+ * @param nextSend Earliest Time for the next Datagram in us (SEND_INTERVAL_MS)
+ */
+void send_frames_udp(frame_t **pending, int *retries, int64_t *nextSend);
+
+/**
+ * @brief Send at most one requested Retransmission, only to the Receiver which lost the Frame
+ * 
+ */
+void send_retransmission(void);
+
+/**
+ * @brief Count the Capture-to-Send Latency of a Frame for its Frame Mode
+ * 
+ * @param frame Frame which was just handed to lwIP
+ */
+void record_latency(frame_t *frame);
+
+/**
+ * @brief Join the Multicast Stream from configuration.h to the Destination List
+ * 
+ * @return -1 if Setup failed // 0 if Multicast is disabled // 1 if Setup successfull
+ */
+int init_multicast(void);
+
+/**
+ * @brief Send one Frame as Datagram with the raw lwIP Sender or sendto(), depending on UDP_RAW_SENDER
+ * 
+ * @param frame Frame to send
+ * @param addr Address of the Receiver
+ * @return -1 if send failed // 0 if lwIP/WiFi is out of Buffers // 1 if send successfull
+ */
+int send_datagram(frame_t *frame, const struct sockaddr_in *addr);
+
+/**
+ * @brief Send one Frame to one Receiver
+ * 
+ * @param frame Frame to send
+ * @param addr Address of the Receiver
+ * @return -1 if send failed // 0 if lwIP/WiFi is out of Buffers // 1 if send successfull
+ */
+int send_frame_udp(frame_t *frame, const struct sockaddr_in *addr);
 
 /**
- * @brief Initialize CoAP Client and Connect to Local Server
+ * @brief Send the same Frame to every Receiver in the Destination List. Failures are counted and logged per Receiver
  * 
+ * @param frame Frame to send
+ * @return -1 if send failed for every Receiver // 0 if lwIP/WiFi is out of Buffers before any Receiver got the Frame
+ * // 1 if at least one Receiver got the Frame
  */
-void init_coap(void);
+int send_frame_all(frame_t *frame);
 
 /**
- * @brief Copy Ringbuffer to Array and send Array via CoAP to Local Server
+ * @brief Function to send Frames from the Transmit Queue over TCP to Local Server. Reconnects and resumes after the last
+ * acknowledged Frame from the Retransmission History
+ * 
+ * @param pvParameters NULL
+ */
+void send_task_tcp(void *pvParameters);
+
+/**
+ * @brief Execute one Command from the Settings-Socket
+ * 
+ * @param message Received Message, first Byte is the Command (control.h)
+ * @param length Length of Message in Bytes
+ * @param from Sender of the Message, gets the Time-Sync Reply
+ */
+void handle_control_message(uint8_t *message, int length, struct sockaddr_in *from);
+
+/**
+ * @brief Take SensorID and Server from a CoAP Enrollment (COAP_DISCOVERY). Before the first Enrollment init_udp() is
+ * not called yet, later Enrollments move the Destination like a new Data-Port on the Register-Socket
+ * 
+ * @param id New SensorID
+ * @param server Collector with Data-Port
+ */
+void enroll_sensor(uint8_t id, const struct sockaddr_in *server);
+
+/**
+ * @brief Start the Measurement, from the Start-Broadcast or /control/start. Does nothing if it is already running
+ * 
+ */
+void start_measurement(void);
+
+/**
+ * @brief Read all waiting Messages from the Settings-Socket without blocking
+ * 
+ */
+void receive_control(void);
+
+/**
+ * @brief Read all waiting Messages from the Register-Socket without blocking. The Server can change SensorID and Data-Port
+ * with the same Messages as in init_udp()
+ * 
+ */
+void receive_register(void);
+
+/**
+ * @brief Print Counters of the Frame Pool to Log
+ * 
+ */
+void log_frame_stats(void);
+
+/**
+ * @brief Function to send Frames from the Transmit Queue as CoAP POST to COAP_SERVERADDRESS. libcoap transfers every
+ * Frame in Blocks (Q-Block1) and recovers missing Blocks
  * 
  * @param pvParameters NULL
  */
 void send_task_coap(void *pvParameters);
 
+/**
+ * @brief Function to publish Frames from the Transmit Queue on the Observe Resource /audio. Every Observer gets a NON
+ * Notification per Frame, Clients attach and detach without Registration at the Settings Port
+ * 
+ * @param pvParameters NULL
+ */
+void send_task_observe(void *pvParameters);
+
 /**
  * @brief Function to Sync Localtime with Server via SNTP
  * 
@@ -172,6 +387,7 @@ void init_nvs(void)
 
 bool write_task(void)
 {   
+    uint32_t busyStart = pipeline_begin();
     ISRMutex = pdFALSE;
     testVar = testVar + 1;
     if(testVar == 50000)
@@ -208,6 +424,7 @@ bool write_task(void)
                 //gptimer_get_raw_count(stopwatchtimer, &time_elapsed);
                 MutexHolder1 = pdFALSE;
                 lastBufferWritten = 1;
+                vTaskNotifyGiveFromISR(collect_task_handle, &ISRMutex);
             }
         }
     }
@@ -240,11 +457,13 @@ bool write_task(void)
                 xSemaphoreGiveFromISR(ringbuffer2_mutex, &ISRMutex);
                 MutexHolder2 = pdFALSE;
                 lastBufferWritten = 2;
+                vTaskNotifyGiveFromISR(collect_task_handle, &ISRMutex);
             }
         }
     }
 
-    return ISRMutex == pdFALSE;
+    pipeline_end(STAGE_ACQUISITION, busyStart);
+    return ISRMutex == pdTRUE;
 }
 
 int init_udp(void)
@@ -253,43 +472,51 @@ int init_udp(void)
     int reg_message = 0;
     int data_port = 0;
 
-    init_addr.sin_addr.s_addr = inet_addr(LOCALHOST_ADDRESS);
-    init_addr.sin_family = AF_INET;
-    init_addr.sin_port = htons(LOCALHOST_PORT);
-
     init_sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0)
+    if (init_sock < 0)
     {
         ESP_LOGI(tag_socket, "Unable to create socket: errno %d", errno);
         return -1;
     }
-    ESP_LOGI(tag_socket, "Socket created, connecting to %s, %d", LOCALHOST_ADDRESS, LOCALHOST_PORT);
-    
-    err = sendto(init_sock, &reg_message, sizeof(reg_message), 0, (struct sockaddr *)&init_addr, sizeof(init_addr));
-    if(err < 0)
-    {
-        ESP_LOGE(tag_socket, "Failed to send Register!");
-    }
-    else{
-        ESP_LOGI(tag_socket, "Register send");
-    }
 
-    err = recvfrom(init_sock, &sensorID, sizeof(sensorID), 0, (struct sockaddr *)&server_addr, &server_addr_len);
-    if(err < 0)
+    if (COAP_DISCOVERY)
     {
-        ESP_LOGE(tag_socket, "Failed to receive Register ID!");
+        // Server and SensorID are already set by the Enrollment, no Round Trip to LOCALHOST_ADDRESS
+        data_port = server_addr.sin_port;
     }
-    else{
-        ESP_LOGI(tag_socket, "Received IP: %s and SensorID: %u", inet_ntoa(server_addr.sin_addr), sensorID);
-    }
-
-    err = recvfrom(init_sock, &data_port, sizeof(data_port), 0, (struct sockaddr *)&server_addr, &server_addr_len);
-    if(err < 0)
+    else
     {
-        ESP_LOGE(tag_socket, "Failed to receive Register!");
-    }
-    else{
-        ESP_LOGI(tag_socket, "Received IP: %s and port: %d", inet_ntoa(server_addr.sin_addr), ntohs(data_port));
+        init_addr.sin_addr.s_addr = inet_addr(LOCALHOST_ADDRESS);
+        init_addr.sin_family = AF_INET;
+        init_addr.sin_port = htons(LOCALHOST_PORT);
+        ESP_LOGI(tag_socket, "Socket created, connecting to %s, %d", LOCALHOST_ADDRESS, LOCALHOST_PORT);
+
+        err = sendto(init_sock, &reg_message, sizeof(reg_message), 0, (struct sockaddr *)&init_addr, sizeof(init_addr));
+        if(err < 0)
+        {
+            ESP_LOGE(tag_socket, "Failed to send Register!");
+        }
+        else{
+            ESP_LOGI(tag_socket, "Register send");
+        }
+
+        err = recvfrom(init_sock, &sensorID, sizeof(sensorID), 0, (struct sockaddr *)&server_addr, &server_addr_len);
+        if(err < 0)
+        {
+            ESP_LOGE(tag_socket, "Failed to receive Register ID!");
+        }
+        else{
+            ESP_LOGI(tag_socket, "Received IP: %s and SensorID: %u", inet_ntoa(server_addr.sin_addr), sensorID);
+        }
+
+        err = recvfrom(init_sock, &data_port, sizeof(data_port), 0, (struct sockaddr *)&server_addr, &server_addr_len);
+        if(err < 0)
+        {
+            ESP_LOGE(tag_socket, "Failed to receive Register!");
+        }
+        else{
+            ESP_LOGI(tag_socket, "Received IP: %s and port: %d", inet_ntoa(server_addr.sin_addr), ntohs(data_port));
+        }
     }
 
     server_addr.sin_family = AF_INET;
@@ -315,181 +542,923 @@ int init_udp(void)
     return 1;
 }
 
-void send_task_udp(void *pvParameters)
+int init_multicast(void)
+{
+    int err;
+    uint8_t ttl = MULTICAST_TTL;
+    struct in_addr interface_addr;
+    struct sockaddr_in multicast_addr;
+
+    if (sizeof(MULTICAST_ADDRESS) <= 1)
+    {
+        return 0;
+    }
+
+    err = setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    if (err < 0)
+    {
+        ESP_LOGE(tag_socket, "Failed to set Multicast TTL: errno %d", errno);
+        return -1;
+    }
+
+    // Send Multicast over the WiFi Station Interface
+    interface_addr.s_addr = INADDR_ANY;
+    err = setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &interface_addr, sizeof(interface_addr));
+    if (err < 0)
+    {
+        ESP_LOGE(tag_socket, "Failed to set Multicast Interface: errno %d", errno);
+        return -1;
+    }
+
+    memset(&multicast_addr, 0, sizeof(multicast_addr));
+    multicast_addr.sin_family = AF_INET;
+    multicast_addr.sin_addr.s_addr = inet_addr(MULTICAST_ADDRESS);
+    multicast_addr.sin_port = htons(MULTICAST_PORT);
+    if (add_destination(destinations, &multicast_addr) < 0)
+    {
+        return -1;
+    }
+    ESP_LOGI(tag_socket, "Multicast Stream to %s, %d", MULTICAST_ADDRESS, MULTICAST_PORT);
+
+    return 1;
+}
+
+void copy_buffer_to_frame(ringbuffer_handle_t *buffer, frame_t *frame, const bitrate_profile_t *profile)
+{
+    uint count = 0;
+
+    if(frame == NULL)
+    {
+        while (is_full(buffer))
+        {
+            read_from_buffer(buffer);
+        }
+        return;
+    }
+
+    // Profile 0 keeps the Word equal to the SensorID
+    frame->data[frame->length] = sensorID | ((uint32_t)(profile->decimation - 1) << 16) | ((profile->sampleBits == 16) ? (1 << 24) : 0);
+    frame->length++;
+    frame->data[frame->length] = get_timediff_us(&buffer->timestamp, &measuringStart);
+    frame->length++;
+    // The whole Buffer is copied, the Encode-Stage drops the Samples skipped by the Decimation
+    while (is_full(buffer))
+    {
+        frame->data[frame->length] = read_from_buffer(buffer);
+        frame->length++;
+        count++;
+    }
+    frame->rawSamples = count;
+    frame->rawBlocks++;
+}
+
+frame_t *receive_encoded_frame(TickType_t wait)
+{
+    frame_t *frame = receive_frame(frame_pool, wait);
+
+    if (frame != NULL)
+    {
+        encode_frame(frame);
+    }
+    return frame;
+}
+
+void start_write_timer(void)
+{
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = write_task,
+    };
+    // Interrupt is allocated on the Core calling this
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(writetimer, &cbs, NULL));
+
+    gptimer_alarm_config_t alarm_config = {
+    .reload_count = 0,
+    .alarm_count = SENSOR_RATE,
+    .flags.auto_reload_on_alarm = true,
+    };
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(writetimer, &alarm_config));
+
+    ESP_ERROR_CHECK(gptimer_enable(writetimer));
+    ESP_ERROR_CHECK(gptimer_start(writetimer));
+}
+
+void collect_task(void *pvParameters)
 {
-    int err = 0;
     int lastBufferRead = 2;
-    uint32_t buffer_array[(RINGBUFFER_SIZE * 2) + 4] = {0}; // +2 for timestamps +2 for SensorID
-    int counter = 0;    
+    uint32_t sequence = 0;
+    frame_t *frame = NULL;
+    bool dropFrame = false;
+    const bitrate_profile_t *profile = bitrate_profile(bitrate);
+    frame_mode_t mode = frameMode;
+    uint blocks = 0;
+    int blockSize = 0;
+    ringbuffer_handle_t *buffer;
+    SemaphoreHandle_t mutex;
+    uint32_t busyStart;
+
+    collect_task_handle = xTaskGetCurrentTaskHandle();
+    start_write_timer();
 
     while(1)
     {
-        if (lastBufferRead == 2)
+        // Backpressure: wait for the Send-Task to return a Frame, then apply the Drop Policy
+        if(frame == NULL && !dropFrame)
         {
-            //ESP_LOGI(tag_debug, "Time Buffer 1 blocked Write_task: %llu us", time_elapsed);
-            xSemaphoreTake(ringbuffer1_mutex, (TickType_t) portMAX_DELAY);
-            //gptimer_set_raw_count(stopwatchtimer, 0);
-            if (is_full(ringbuffer1))
+            frame = get_free_frame(frame_pool, FRAME_POOL_WAIT(frameMode));
+            dropFrame = (frame == NULL);
+            // All Blocks of a Frame use the same Profile and Mode
+            profile = bitrate_profile(bitrate);
+            mode = frameMode;
+            if (frame != NULL)
             {
-                buffer_array[counter] = htonl(sensorID);
-                counter++;
-                buffer_array[counter] = htonl(get_timediff_us(&ringbuffer1->timestamp, &measuringStart));
-                counter++;
-                while (is_full(ringbuffer1))
-                {
-                    buffer_array[counter] = htonl(read_from_buffer(ringbuffer1));
-                    counter++;
-                }
-                //gptimer_get_raw_count(stopwatchtimer, &time_elapsed);
-                xSemaphoreGive(ringbuffer1_mutex);
-                //ESP_LOGI(tag_debug, "Time Buffer 1 blocked Send_task: %llu us", time_elapsed);
+                frame->seq = sequence;
+                frame->data[0] = htonl(sequence);
+                frame->length = FRAME_SEQUENCE ? 1 : 0;
+                frame->mode = mode;
+                frame->rawBlocks = 0;
+                frame->decimation = profile->decimation;
+                frame->sampleBits = profile->sampleBits;
             }
-            else
+        }
+
+        if (lastBufferRead == 2)
+        {
+            buffer = ringbuffer1;
+            mutex = ringbuffer1_mutex;
+        }
+        else
+        {
+            buffer = ringbuffer2;
+            mutex = ringbuffer2_mutex;
+        }
+
+        xSemaphoreTake(mutex, (TickType_t) portMAX_DELAY);
+        if (!is_full(buffer))
+        {
+            // Write-Task has not started this Buffer yet, it notifies when a Buffer is full
+            xSemaphoreGive(mutex);
+            ulTaskNotifyTake(pdTRUE, 1);
+            continue;
+        }
+        busyStart = pipeline_begin();
+        if (blocks == 0)
+        {
+            blockSize = buffer->size;
+            if (frame != NULL)
             {
-                xSemaphoreGive(ringbuffer1_mutex);
+                frame->captureTime = ((int64_t)buffer->timestamp.tv_sec * 1000000) + buffer->timestamp.tv_usec;
             }
-            lastBufferRead = 1;
         }
-        else if (lastBufferRead == 1)
+        copy_buffer_to_frame(buffer, frame, profile);
+        // Buffer is empty and locked: the next Block gets the Size of the latest Mode
+        if (buffer->size != (int)frame_modes[frameMode].blockSize)
+        {
+            set_buffer_size(buffer, frame_modes[frameMode].blockSize);
+        }
+        xSemaphoreGive(mutex);
+
+        lastBufferRead = (lastBufferRead == 2) ? 1 : 2;
+        buffer = (lastBufferRead == 2) ? ringbuffer1 : ringbuffer2;
+        blocks++;
+        // After a Mode Switch the Frame ends early, so all Blocks of a Frame have the same Size
+        if (blocks >= frame_modes[mode].blocksPerFrame || buffer->size != blockSize)
         {
-            xSemaphoreTake(ringbuffer2_mutex, (TickType_t) portMAX_DELAY);
-            //gptimer_set_raw_count(stopwatchtimer, 0);
-            if (is_full(ringbuffer2))
+            if (frame != NULL)
             {
-                buffer_array[counter] = htonl(sensorID);
-                counter++;
-                buffer_array[counter] = htonl(get_timediff_us(&ringbuffer2->timestamp, &measuringStart));
-                counter++;
-                while (is_full(ringbuffer2))
+                if (blocks == 1)
                 {
-                    buffer_array[counter] = htonl(read_from_buffer(ringbuffer2));
-                    counter++;
+                    frame->data[FRAME_SEQUENCE ? 1 : 0] |= FRAME_SINGLE_BLOCK;
                 }
-                //gptimer_get_raw_count(stopwatchtimer, &time_elapsed);  
-                xSemaphoreGive(ringbuffer2_mutex);
-                //ESP_LOGI(tag_debug, "Time Buffer 2 blocked Send_task: %llu us", time_elapsed);       
+                submit_frame(frame_pool, frame);
             }
-            else
+            blocks = 0;
+            // Dropped Frames use a Sequence Number too, so the Server can see the Gap
+            sequence++;
+            frame = NULL;
+            dropFrame = false;
+        }
+        pipeline_end(STAGE_COLLECT, busyStart);
+    }
+}
+
+void net_task(void *pvParameters)
+{
+    fd_set readfds;
+    struct timeval timeout;
+    int maxfd;
+    int ready;
+    uint64_t events;
+    uint8_t discard[CONTROL_MESSAGE_SIZE];
+    frame_t *pending = NULL;
+    int retries = 0;
+    int64_t nextSend = 0;
+    int64_t lastStats = esp_timer_get_time();
+    int64_t wait;
+    uint32_t busyStart;
+
+    while(1)
+    {
+        // Sleep until a Socket is readable or a Frame is submitted. Retries, Retransmissions and Pacing shorten the Timeout
+        wait = NET_IDLE_TIMEOUT_US;
+        if (pending != NULL || arq_has_requests(arq))
+        {
+            wait = portTICK_PERIOD_MS * 1000;
+        }
+        if (nextSend - esp_timer_get_time() > 0 && nextSend - esp_timer_get_time() < wait)
+        {
+            wait = nextSend - esp_timer_get_time();
+        }
+        timeout.tv_sec = wait / 1000000;
+        timeout.tv_usec = wait % 1000000;
+
+        FD_ZERO(&readfds);
+        FD_SET(setting_sock, &readfds);
+        FD_SET(init_sock, &readfds);
+        FD_SET(sock, &readfds);
+        maxfd = (setting_sock > init_sock) ? setting_sock : init_sock;
+        maxfd = (sock > maxfd) ? sock : maxfd;
+        if (STREAM_TRANSPORT_UDP && frame_event_fd >= 0)
+        {
+            FD_SET(frame_event_fd, &readfds);
+            maxfd = (frame_event_fd > maxfd) ? frame_event_fd : maxfd;
+        }
+
+        if (coap_control != NULL)
+        {
+            // Same select() also serves the CoAP Control Resources, the Sets only hold readable Sockets afterwards
+            ready = coap_control_process(coap_control, (wait + 999) / 1000, maxfd + 1, &readfds);
+        }
+        else
+        {
+            ready = select(maxfd + 1, &readfds, NULL, NULL, &timeout);
+        }
+        if (ready < 0)
+        {
+            ESP_LOGE(tag_socket, "select failed: errno %d", errno);
+            vTaskDelay(1);
+            continue;
+        }
+
+        busyStart = pipeline_begin();
+        if (ready > 0)
+        {
+            if (STREAM_TRANSPORT_UDP && frame_event_fd >= 0 && FD_ISSET(frame_event_fd, &readfds))
+            {
+                // Counter only wakes up the Loop, Frames are taken from the Transmit Ring
+                read(frame_event_fd, &events, sizeof(events));
+            }
+            if (FD_ISSET(setting_sock, &readfds))
+            {
+                receive_control();
+            }
+            if (FD_ISSET(init_sock, &readfds))
+            {
+                receive_register();
+            }
+            if (FD_ISSET(sock, &readfds))
             {
-                xSemaphoreGive(ringbuffer2_mutex);
+                // Nothing is expected on the Data-Socket, keep its Receive Buffer empty
+                while (recv(sock, discard, sizeof(discard), 0) >= 0);
             }
-            lastBufferRead = 2;
-            counter = 0;
+        }
+        pipeline_end(STAGE_CONTROL, busyStart);
 
-            gettimeofday(&beginnSend, NULL);
-            if (get_timediff_us(&endSend, &beginnSend) > 50000)
-            {   
-                gptimer_get_raw_count(stopwatchtimer, &time_elapsed);
-                err = sendto(sock, &buffer_array, sizeof(buffer_array), 0, (struct sockaddr *)&server_addr, sizeof(server_addr));
-                gptimer_set_raw_count(stopwatchtimer, 0);
-                gettimeofday(&endSend, NULL);
-                if (err < 0)
-                {
-                    ESP_LOGE(tag_socket, "Send failed! err: %d", errno);
-                    perror("Fehlertext");
-                }
-                else
-                {
-                    ESP_LOGI(tag_debug, "Time to send UDP-Package: %llu us", time_elapsed);
-                    ESP_LOGI(tag_socket, "Successfully send");
-                }  
-            }      
-        }                                 
+        if (STREAM_TRANSPORT_UDP)
+        {
+            busyStart = pipeline_begin();
+            send_frames_udp(&pending, &retries, &nextSend);
+            pipeline_end(STAGE_SEND, busyStart);
+        }
+
+        if (esp_timer_get_time() - lastStats > STATS_INTERVAL_US)
+        {
+            log_frame_stats();
+            lastStats = esp_timer_get_time();
+        }
     }
 }
 
-void init_coap(void)
+void send_frames_udp(frame_t **pending, int *retries, int64_t *nextSend)
 {
-    coap_startup();
+    frame_t *frame;
+    frame_t *evicted;
+    int err;
+    bool burst;
+
+    // Throughput Mode collects a Batch of Frames and sends them back to back
+    burst = (*pending != NULL) || (queued_frames(frame_pool) >= frame_modes[frameMode].batch);
+
+    while (burst && esp_timer_get_time() >= *nextSend)
+    {
+        frame = (*pending != NULL) ? *pending : receive_encoded_frame(0);
+        if (frame == NULL)
+        {
+            break;
+        }
+
+        err = send_frame_all(frame);
+        if (err == 0 && *retries < SEND_RETRY_MAX)
+        {
+            // lwIP/WiFi is out of Buffers: keep the Frame and return to select(), Control Messages are served meanwhile
+            atomic_fetch_add(&frame_pool->stats.sendRetries, 1);
+            (*retries)++;
+            *pending = frame;
+            return;
+        }
+        *pending = NULL;
+        *retries = 0;
+
+        if (err <= 0)
+        {
+            atomic_fetch_add(&frame_pool->stats.sendFailed, 1);
+        }
+        else
+        {
+            atomic_fetch_add(&frame_pool->stats.sent, 1);
+            atomic_fetch_add(&frame_pool->stats.bytesSent, frame->length * sizeof(uint32_t));
+            record_latency(frame);
+        }
 
-    coap_context = coap_new_context(NULL);
+        if (ARQ_ENABLE)
+        {
+            // Keep Frame for Retransmission and give the oldest one back to the Pool
+            evicted = arq_store_frame(arq, frame);
+            if (evicted != NULL)
+            {
+                release_frame(frame_pool, evicted);
+            }
 
-    coap_address_init(&coap_address);
-    coap_address.addr.sin.sin_family = AF_INET;
-    coap_address.addr.sin.sin_addr.s_addr = inet_addr(COAP_SERVERADDRESS);
-    coap_address.addr.sin.sin_port = htons(COAP_PORT);
+            // At most one Retransmission per live Frame, so Retransmissions never starve live Traffic
+            send_retransmission();
+        }
+        else
+        {
+            release_frame(frame_pool, frame);
+        }
+
+        if (SEND_INTERVAL_MS > 0)
+        {
+            *nextSend = esp_timer_get_time() + (SEND_INTERVAL_MS * 1000);
+        }
+    }
 
-    coap_session = coap_new_client_session(coap_context, NULL, &coap_address, COAP_PROTO_UDP);
-    if(coap_session == NULL)
+    // Retransmissions are also send while no new Frame is available
+    if (*pending == NULL && esp_timer_get_time() >= *nextSend)
     {
-        ESP_LOGE(tag_coap, "Failed to create CoAP Session!");
+        send_retransmission();
+    }
+}
+
+void send_retransmission(void)
+{
+    frame_t *frame;
+    struct in_addr requester;
+    struct sockaddr_in addr;
+
+    frame = arq_next_retransmission(arq, &requester);
+    if (frame == NULL)
+    {
+        return;
+    }
+
+    // Only the Receiver which lost the Frame gets it again. A Retransmission without Buffers is lost, the Receiver sends another NACK
+    if (find_destination(destinations, requester, &addr) > 0)
+    {
+        send_frame_udp(frame, &addr);
     }
     else
     {
-        ESP_LOGI(tag_coap, "CoAP Session created!");
+        send_frame_all(frame);
     }
+}
 
+void record_latency(frame_t *frame)
+{
+    struct timeval tv;
+    frame_latency_t *latency = &frame_latency[frame->mode];
+    uint32_t us;
+
+    gettimeofday(&tv, NULL);
+    us = (uint32_t)((((int64_t)tv.tv_sec * 1000000) + tv.tv_usec) - frame->captureTime);
+    latency->frames++;
+    latency->sumUs += us;
+    if (us > latency->maxUs)
+    {
+        latency->maxUs = us;
+    }
 }
 
-void send_task_coap(void *pvParameters)
+int send_datagram(frame_t *frame, const struct sockaddr_in *addr)
 {
-    int lastBufferRead = 1;
-    uint32_t buffer_array[RINGBUFFER_SIZE] = {0};
-    uint8_t payload[sizeof(buffer_array)];
-    uint8_t content_type_buffer[2];
-    size_t content_type_length = coap_encode_var_safe(content_type_buffer, sizeof(content_type_buffer), COAP_MEDIATYPE_APPLICATION_OCTET_STREAM);
+    int err;
 
-    init_coap();
+    if (UDP_RAW_SENDER && udp_raw != NULL)
+    {
+        return udp_raw_send_frame(udp_raw, frame, addr);
+    }
+
+    err = sendto(sock, frame->data, frame->length * sizeof(uint32_t), 0, (struct sockaddr *)addr, sizeof(*addr));
+    if (err < 0)
+    {
+        return (errno == ENOMEM || errno == ENOBUFS) ? 0 : -1;
+    }
+
+    return 1;
+}
+
+int send_frame_udp(frame_t *frame, const struct sockaddr_in *addr)
+{
+    int err;
+
+    err = send_datagram(frame, addr);
+    if (err == 0)
+    {
+        return 0;
+    }
+    if (err < 0)
+    {
+        ESP_LOGE(tag_socket, "Send failed! err: %d", errno);
+        return -1;
+    }
+
+    ESP_LOGI(tag_socket, "Successfully send");
+    return 1;
+}
+
+int send_frame_all(frame_t *frame)
+{
+    struct sockaddr_in addr[DESTINATION_MAX];
+    uint count;
+    int err[DESTINATION_MAX];
+    int ret = -1;
+
+    // Frame is encoded once, every Receiver gets the same Buffer
+    count = copy_destinations(destinations, addr);
+    for (uint i = 0; i < count; i++)
+    {
+        err[i] = send_frame_udp(frame, &addr[i]);
+        if (err[i] > 0)
+        {
+            ret = 1;
+        }
+        else if (err[i] == 0 && ret < 0)
+        {
+            // Out of Buffers before any Receiver got the Frame: the Caller retries the whole Frame
+            return 0;
+        }
+    }
+
+    // The Frame counts as sent if one Receiver got it, the others count it as failed
+    for (uint i = 0; i < count; i++)
+    {
+        if (err[i] <= 0)
+        {
+            ESP_LOGE(tag_socket, "Frame %lu not send to %s:%d", frame->seq, inet_ntoa(addr[i].sin_addr), ntohs(addr[i].sin_port));
+        }
+        count_destination(destinations, &addr[i], err[i] > 0);
+    }
+
+    return ret;
+}
+
+void send_task_tcp(void *pvParameters)
+{
+    frame_t *frame;
+    frame_t *resume[TCP_UNACKED_FRAMES];
+    uint count;
+    uint32_t busyStart;
+    uint32_t lastAcked = tcp_stream->lastAcked;
+    int64_t lastProgress = 0;
 
     while(1)
     {
-        int counter = 0;
-        coap_message = coap_new_pdu(COAP_MESSAGE_NON, COAP_REQUEST_CODE_POST, coap_session);
-        coap_add_option(coap_message, COAP_OPTION_CONTENT_TYPE, content_type_length, content_type_buffer);
-        
-        if (lastBufferRead == 2)
+        if (tcp_stream->sock < 0)
         {
-            xSemaphoreTake(ringbuffer1_mutex, (TickType_t) portMAX_DELAY);
-            if (is_full(ringbuffer1))
+            if (tcp_stream_connect(tcp_stream) < 0)
             {
-                while (is_full(ringbuffer1))
+                // Frames wait in the Transmit Queue, the Drop Policy applies if the Pool runs empty
+                vTaskDelay(TCP_RECONNECT_DELAY_MS / portTICK_PERIOD_MS);
+                continue;
+            }
+
+            // Resume after the last acknowledged Frame, every unacknowledged Frame is still in the History
+            count = arq_history_after(arq, tcp_stream->lastAcked, resume);
+            for (uint i = 0; i < count; i++)
+            {
+                if (tcp_stream_send_frame(tcp_stream, resume[i]) < 0)
                 {
-                    buffer_array[counter] = read_from_buffer(ringbuffer1);
-                    counter++;
-                    //ESP_LOGI(tag_ringbuffer1, "ReadIndex: %d, IsFull: %d", ringbuffer1->readIndex, ringbuffer1->full);
+                    tcp_stream_close(tcp_stream);
+                    break;
                 }
-                xSemaphoreGive(ringbuffer1_mutex);    
+                arq->stats.retransmitted++;
+            }
+            lastProgress = esp_timer_get_time();
+            continue;
+        }
+
+        // At most TCP_UNACKED_FRAMES are in flight, further Frames wait in the Transmit Queue for Acks
+        frame = NULL;
+        if (arq->historyCount < TCP_UNACKED_FRAMES)
+        {
+            frame = receive_encoded_frame(1);
+        }
+        else
+        {
+            vTaskDelay(1);
+        }
+        busyStart = pipeline_begin();
+        if (frame != NULL)
+        {
+            if (arq->historyCount == 0)
+            {
+                lastProgress = esp_timer_get_time();
+            }
+            if (tcp_stream_send_frame(tcp_stream, frame) < 0)
+            {
+                atomic_fetch_add(&frame_pool->stats.sendFailed, 1);
+                tcp_stream_close(tcp_stream);
             }
             else
             {
-                xSemaphoreGive(ringbuffer1_mutex);
+                atomic_fetch_add(&frame_pool->stats.sent, 1);
+                atomic_fetch_add(&frame_pool->stats.bytesSent, frame->length * sizeof(uint32_t));
+                record_latency(frame);
             }
-            lastBufferRead = 1;
+
+            // Failed Frames stay in History too and are send again after Reconnect, nothing is evicted below TCP_UNACKED_FRAMES
+            arq_store_frame(arq, frame);
+        }
+
+        if (tcp_stream->sock >= 0 && tcp_stream_poll_ack(tcp_stream) < 0)
+        {
+            tcp_stream_close(tcp_stream);
+        }
+        // Acknowledged Frames go back to the Pool
+        while ((frame = arq_pop_acked(arq, tcp_stream->lastAcked)) != NULL)
+        {
+            release_frame(frame_pool, frame);
         }
-        else if (lastBufferRead == 1)
+        if (tcp_stream->lastAcked != lastAcked)
         {
-            xSemaphoreTake(ringbuffer2_mutex, (TickType_t) portMAX_DELAY);
-            if (is_full(ringbuffer2))
+            lastAcked = tcp_stream->lastAcked;
+            lastProgress = esp_timer_get_time();
+        }
+        // No Ack for the unacknowledged Frames: the Link is dead even if the Send Buffer took every Frame
+        if (tcp_stream->sock >= 0 && arq->historyCount > 0 && esp_timer_get_time() - lastProgress > TCP_STALL_TIMEOUT_MS * 1000)
+        {
+            ESP_LOGE(tag_socket, "No Ack after %lu for %d ms, reconnecting", lastAcked, TCP_STALL_TIMEOUT_MS);
+            tcp_stream_close(tcp_stream);
+        }
+        pipeline_end(STAGE_SEND, busyStart);
+    }
+}
+
+void enroll_sensor(uint8_t id, const struct sockaddr_in *server)
+{
+    if (sensorEnrolled)
+    {
+        remove_destination(destinations, &server_addr);
+        add_destination(destinations, server);
+    }
+    sensorID = id;
+    server_addr = *server;
+    sensorEnrolled = 1;
+    ESP_LOGI(tag_socket, "Enrolled by %s, port: %d, SensorID: %u", inet_ntoa(server->sin_addr), ntohs(server->sin_port), id);
+}
+
+void start_measurement(void)
+{
+    if (startMeasurement != CONTROL_START)
+    {
+        startMeasurement = CONTROL_START;
+        xEventGroupSetBits(net_events, NET_START_BIT);
+    }
+}
+
+void handle_control_message(uint8_t *message, int length, struct sockaddr_in *from)
+{
+    struct sockaddr_in addr;
+    struct timeval tv;
+    uint8_t reply[CONTROL_TIME_SYNC_REPLY_SIZE];
+    uint32_t value;
+    uint32_t jitter;
+    uint16_t loss;
+    int err;
+
+    switch (message[0])
+    {
+        case CONTROL_START:
+            // Repeated Start-Broadcasts are ignored
+            start_measurement();
+            break;
+        case CONTROL_NACK:
+            if (!ARQ_ENABLE || !STREAM_TRANSPORT_UDP)
             {
-                while (is_full(ringbuffer2))
-                {
-                    buffer_array[counter] = read_from_buffer(ringbuffer2);
-                    counter++;
-                    //ESP_LOGI(tag_ringbuffer2, "ReadIndex: %d, IsFull: %d", ringbuffer2->readIndex, ringbuffer2->full);
-                }
-                xSemaphoreGive(ringbuffer2_mutex);           
+                // Frames carry no Sequence Number the NACK could refer to, or the Transport recovers Losses itself
+                break;
+            }
+            if (arq_parse_nack(arq, &message[1], length - 1, from->sin_addr) < 0)
+            {
+                ESP_LOGE(tag_socket, "Malformed NACK with %d Bytes", length);
+            }
+            break;
+        case CONTROL_ADD_DESTINATION:
+        case CONTROL_REMOVE_DESTINATION:
+            if (length != 7)
+            {
+                ESP_LOGE(tag_socket, "Malformed Destination with %d Bytes", length);
+                break;
+            }
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            memcpy(&addr.sin_addr.s_addr, &message[1], 4);
+            memcpy(&addr.sin_port, &message[5], 2);
+            if (message[0] == CONTROL_ADD_DESTINATION)
+            {
+                err = add_destination(destinations, &addr);
             }
             else
             {
-                xSemaphoreGive(ringbuffer2_mutex);
+                err = remove_destination(destinations, &addr);
+            }
+            ESP_LOGI(tag_socket, "Destination %s:%d %s (%d)", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port),
+                     message[0] == CONTROL_ADD_DESTINATION ? "added" : "removed", err);
+            break;
+        case CONTROL_TIME_SYNC:
+            if (length != 5)
+            {
+                ESP_LOGE(tag_socket, "Malformed Time-Sync with %d Bytes", length);
+                break;
             }
-            lastBufferRead = 2;    
+            // Token, Sensor Time and Time since Measurement Start, so the Server can compute Offset and Round Trip
+            gettimeofday(&tv, NULL);
+            reply[0] = CONTROL_TIME_SYNC;
+            memcpy(&reply[1], &message[1], 4);
+            value = htonl(tv.tv_sec);
+            memcpy(&reply[5], &value, 4);
+            value = htonl(tv.tv_usec);
+            memcpy(&reply[9], &value, 4);
+            value = htonl(startMeasurement == CONTROL_START ? get_timediff_us(&tv, &measuringStart) : 0);
+            memcpy(&reply[13], &value, 4);
+            if (sendto(setting_sock, reply, sizeof(reply), 0, (struct sockaddr *)from, sizeof(*from)) < 0)
+            {
+                ESP_LOGE(tag_socket, "Time-Sync Reply failed: errno %d", errno);
+            }
+            break;
+        case CONTROL_FRAME_MODE:
+            if (length != 2 || message[1] >= FRAME_MODE_COUNT)
+            {
+                ESP_LOGE(tag_socket, "Malformed Frame Mode with %d Bytes", length);
+                break;
+            }
+            frameMode = message[1];
+            ESP_LOGI(tag_debug, "Frame Mode %u: %u Samples per Block, %u Blocks per Frame", message[1],
+                     frame_modes[frameMode].blockSize, frame_modes[frameMode].blocksPerFrame);
+            break;
+        case CONTROL_FEEDBACK:
+            if (length != 11)
+            {
+                ESP_LOGE(tag_socket, "Malformed Feedback with %d Bytes", length);
+                break;
+            }
+            memcpy(&loss, &message[1], 2);
+            memcpy(&jitter, &message[3], 4);
+            memcpy(&value, &message[7], 4);
+            bitrate_feedback(bitrate, ntohs(loss), ntohl(jitter), ntohl(value));
+            break;
+        default:
+            break;
+    }
+}
+
+void receive_control(void)
+{
+    uint8_t message[CONTROL_MESSAGE_SIZE];
+    struct sockaddr_in from;
+    socklen_t fromLen;
+    int length;
+
+    while(1)
+    {
+        fromLen = sizeof(from);
+        length = recvfrom(setting_sock, message, sizeof(message), 0, (struct sockaddr *)&from, &fromLen);
+        if (length < 0)
+        {
+            // EAGAIN: Socket is empty
+            return;
+        }
+        if (length > 0)
+        {
+            handle_control_message(message, length, &from);
         }
+    }
+}
+
+void receive_register(void)
+{
+    uint8_t message[sizeof(int)];
+    struct sockaddr_in from;
+    socklen_t fromLen;
+    int data_port = 0;
+    int length;
 
-        memcpy(payload, buffer_array, sizeof(buffer_array));
+    while(1)
+    {
+        fromLen = sizeof(from);
+        length = recvfrom(init_sock, message, sizeof(message), 0, (struct sockaddr *)&from, &fromLen);
+        if (length < 0)
+        {
+            return;
+        }
 
-        coap_add_data(coap_message, sizeof(payload), payload);
+        if (length == sizeof(sensorID))
+        {
+            sensorID = message[0];
+            ESP_LOGI(tag_socket, "Received IP: %s and SensorID: %u", inet_ntoa(from.sin_addr), sensorID);
+        }
+        else if (length == sizeof(data_port))
+        {
+            // New Data-Port of the registered Server, same Format as in init_udp()
+            memcpy(&data_port, message, sizeof(data_port));
+            remove_destination(destinations, &server_addr);
+            server_addr.sin_port = data_port;
+            add_destination(destinations, &server_addr);
+            ESP_LOGI(tag_socket, "Received IP: %s and port: %d", inet_ntoa(from.sin_addr), ntohs(data_port));
+        }
+    }
+}
 
-        if(coap_send(coap_session, coap_message) == COAP_INVALID_MID)
+void log_frame_stats(void)
+{
+    frame_pool_stats_t *stats = &frame_pool->stats;
+    struct sockaddr_in addr[DESTINATION_MAX];
+    destination_stats_t receivers[DESTINATION_MAX];
+    uint count;
+    static uint64_t lastBytes = 0;
+    static int64_t lastTime = 0;
+    static uint64_t lastSendUs = 0;
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - lastTime;
+
+    // Sustained Throughput of the active Transport since last Call
+    if (lastTime != 0)
+    {
+        ESP_LOGI(tag_debug, "Throughput: %llu kbit/s", ((atomic_load(&stats->bytesSent) - lastBytes) * 8000) / (now - lastTime));
+    }
+    lastBytes = atomic_load(&stats->bytesSent);
+    lastTime = now;
+
+    ESP_LOGI(tag_debug, "Frames captured: %lu, sent: %lu, dropped oldest: %lu, dropped newest: %lu, failed: %lu, retries: %lu, queued: %u (max %lu)",
+             atomic_load(&stats->captured), atomic_load(&stats->sent), atomic_load(&stats->droppedOldest),
+             atomic_load(&stats->droppedNewest), atomic_load(&stats->sendFailed), atomic_load(&stats->sendRetries),
+             queued_frames(frame_pool), atomic_load(&stats->queueHighWater));
+    ESP_LOGI(tag_debug, "NACKs: %lu, retransmitted: %lu, not in history: %lu, rate limited: %lu, overflow: %lu",
+             arq->stats.nacks, arq->stats.retransmitted, arq->stats.notInHistory, arq->stats.rateLimited, arq->stats.overflow);
+    if (STREAM_TRANSPORT_UDP)
+    {
+        count = copy_destination_stats(destinations, addr, receivers);
+        for (uint i = 0; i < count; i++)
+        {
+            ESP_LOGI(tag_debug, "Receiver %s:%d sent: %lu, failed: %lu", inet_ntoa(addr[i].sin_addr), ntohs(addr[i].sin_port),
+                     receivers[i].sent, receivers[i].failed);
+        }
+    }
+    if (udp_raw != NULL)
+    {
+        ESP_LOGI(tag_debug, "Raw UDP pbufs exhausted: %lu", udp_raw->pbufsExhausted);
+    }
+    if (coap_stream != NULL)
+    {
+        ESP_LOGI(tag_debug, "CoAP (Protocol %d) requests: %lu, blockwise: %lu, responses: %lu, errors: %lu, send failed: %lu, PDU pool misses: %lu",
+                 coap_stream->proto, coap_stream->stats.requests, coap_stream->stats.blockwise, coap_stream->stats.responses,
+                 coap_stream->stats.errors, coap_stream->stats.sendFailed, coap_stream->stats.pduPoolMisses);
+        ESP_LOGI(tag_debug, "CoAP queue: %u frames waiting, %u transfers (max %u), NSTART limited: %lu, probing limited: %lu",
+                 queued_frames(frame_pool), coap_stream->inFlight, coap_stream->stats.inFlightHighWater,
+                 coap_stream->stats.nstartLimited, coap_stream->stats.probingLimited);
+        // Cost of coap_send() incl. DTLS Encryption, the Load is the Share of the Send-Core since the last Call
+        ESP_LOGI(tag_debug, "CoAP sends: %lu, avg %llu us, max %lu us, load %llu per mille, handshakes: %lu (last %lu us), reconnects: %lu",
+                 coap_stream->stats.sends, coap_stream->stats.sends ? coap_stream->stats.sendUs / coap_stream->stats.sends : 0,
+                 coap_stream->stats.sendMaxUs, ((coap_stream->stats.sendUs - lastSendUs) * 1000) / elapsed,
+                 coap_stream->stats.handshakes, coap_stream->stats.handshakeUs, coap_stream->stats.reconnects);
+        lastSendUs = coap_stream->stats.sendUs;
+        // Fixed Pools of libcoap (CONFIG_COAP_MEM_POOL), Failures fell back to the Heap
+        coap_mem_pool_stats_t poolStats[COAP_POOL_STATS_MAX];
+        unsigned int pools = coap_mem_pool_stats(poolStats, COAP_POOL_STATS_MAX);
+        for (unsigned int i = 0; i < pools; i++)
+        {
+            ESP_LOGI(tag_debug, "CoAP pool %s (%u bytes): %u/%u used, high water %u, failures %u", poolStats[i].name,
+                     poolStats[i].block_size, poolStats[i].used, poolStats[i].blocks, poolStats[i].high_water,
+                     poolStats[i].failures);
+        }
+    }
+    if (coap_audio != NULL)
+    {
+        ESP_LOGI(tag_debug, "CoAP Observe published: %lu, unobserved: %lu, representations: %lu, released: %lu, observers of last frame: %u",
+                 coap_audio->stats.published, coap_audio->stats.unobserved, coap_audio->stats.representations,
+                 coap_audio->stats.released, coap_audio->observers);
+    }
+    if (coap_control != NULL)
+    {
+        ESP_LOGI(tag_debug, "CoAP Control requests: %lu, changed: %lu, rejected: %lu, enrollments: %lu",
+                 coap_control->counters.requests, coap_control->counters.changed, coap_control->counters.rejected,
+                 coap_control->counters.enrollments);
+        coap_control_stats_changed(coap_control);
+    }
+    ESP_LOGI(tag_debug, "Bitrate Profile: %u (%lu kbit/s), reports: %lu, down: %lu, up: %lu, last loss: %u, jitter: %lu us, throughput: %lu kbit/s",
+             bitrate->profile, bitrate_kbps(bitrate), bitrate->stats.reports, bitrate->stats.stepsDown, bitrate->stats.stepsUp,
+             bitrate->stats.lossPermille, bitrate->stats.jitterUs, bitrate->stats.throughputKbps);
+    for (int i = 0; i < FRAME_MODE_COUNT; i++)
+    {
+        if (frame_latency[i].frames > 0)
+        {
+            ESP_LOGI(tag_debug, "Capture-to-Send Latency Mode %d%s: avg %llu us, max %lu us over %lu Frames", i,
+                     (i == frameMode) ? " (active)" : "", frame_latency[i].sumUs / frame_latency[i].frames,
+                     frame_latency[i].maxUs, frame_latency[i].frames);
+        }
+    }
+    log_pipeline_load();
+}
+
+void send_task_coap(void *pvParameters)
+{
+    frame_t *frame = NULL;
+    uint32_t busyStart;
+    int err;
+    uint32_t timeout;
+
+    while(1)
+    {
+        // A Frame held back by NSTART or the Probing Rate is kept and offered again
+        if (frame == NULL)
+        {
+            frame = receive_encoded_frame(0);
+        }
+        busyStart = pipeline_begin();
+        if (frame != NULL)
+        {
+            err = coap_stream_send_frame(coap_stream, frame);
+            if (err != 0)
+            {
+                if (err < 0)
+                {
+                    atomic_fetch_add(&frame_pool->stats.sendFailed, 1);
+                }
+                else
+                {
+                    atomic_fetch_add(&frame_pool->stats.sent, 1);
+                    atomic_fetch_add(&frame_pool->stats.bytesSent, frame->length * sizeof(uint32_t));
+                    record_latency(frame);
+                }
+                // libcoap holds its own Reference until the Transfer is done
+                release_frame(frame_pool, frame);
+                frame = NULL;
+            }
+        }
+
+        pipeline_end(STAGE_SEND, busyStart);
+
+        // Blocks, Responses, RSTs and Timeouts of all Transfers. Sleeps in select() until Traffic, a libcoap Timer or a new
+        // Frame, so the Session advances while streaming
+        if (frame != NULL)
+        {
+            timeout = COAP_STREAM_RETRY_MS;
+        }
+        else if (queued_frames(frame_pool) > 0)
         {
-            ESP_LOGE(tag_coap, "Send Failed!");
+            timeout = COAP_IO_NO_WAIT;
         }
         else
         {
-            ESP_LOGI(tag_coap, "Send Successfull!");
+            timeout = COAP_STREAM_IDLE_MS;
         }
+        coap_stream_process(coap_stream, timeout);
+    }
+}
+
+void send_task_observe(void *pvParameters)
+{
+    frame_t *frame;
+    uint32_t busyStart;
 
+    while(1)
+    {
+        frame = receive_encoded_frame(0);
+        busyStart = pipeline_begin();
+        if (frame != NULL)
+        {
+            if (coap_audio_publish(coap_audio, frame) > 0)
+            {
+                atomic_fetch_add(&frame_pool->stats.sent, 1);
+                atomic_fetch_add(&frame_pool->stats.bytesSent, frame->length * sizeof(uint32_t));
+                record_latency(frame);
+            }
+            // The Resource and every Observer hold their own Reference
+            release_frame(frame_pool, frame);
+        }
+        pipeline_end(STAGE_SEND, busyStart);
 
+        // Notifications are built here, before the next Frame replaces the Representation
+        coap_audio_process(coap_audio, (frame != NULL || queued_frames(frame_pool) > 0) ? COAP_IO_NO_WAIT : COAP_STREAM_IDLE_MS);
     }
 }
 
@@ -563,12 +1532,26 @@ void app_main(void)
         ESP_LOGI(tag_ringbuffer2, "Ringbuffer 2 created succesfully!");
     }
 
+    frame_pool = init_frame_pool(FRAME_POOL_SIZE, FRAME_SIZE, FRAME_DROP_POLICY);
+    if (frame_pool)
+    {
+        ESP_LOGI(tag_debug, "Frame Pool created succesfully!");
+    }
+
+    arq = init_arq(ARQ_HISTORY_SIZE, ARQ_RATE, ARQ_BURST);
+    if (arq)
+    {
+        ESP_LOGI(tag_debug, "Retransmission History created succesfully!");
+    }
+
+    destinations = init_destinations();
+    bitrate = init_bitrate(BITRATE_FULL_KBPS);
+
     ringbuffer1_mutex = xSemaphoreCreateMutex();
     ringbuffer2_mutex = xSemaphoreCreateMutex();
     esp_log_level_set(tag_socket, ESP_LOG_ERROR);
     //esp_log_level_set(tag_debug, ESP_LOG_ERROR);
 
-    gptimer_handle_t writetimer = NULL;
     gptimer_config_t timer_config = {
         .clk_src = GPTIMER_CLK_SRC_DEFAULT,
         .direction = GPTIMER_COUNT_UP,
@@ -581,19 +1564,48 @@ void app_main(void)
     gptimer_enable(stopwatchtimer);
     gptimer_start(stopwatchtimer);
 
-    gptimer_event_callbacks_t cbs = {
-        .on_alarm = write_task,
-    };
-    ESP_ERROR_CHECK(gptimer_register_event_callbacks(writetimer, &cbs, NULL));
-
-    gptimer_alarm_config_t alarm_config = {
-    .reload_count = 0,
-    .alarm_count = SENSOR_RATE,
-    .flags.auto_reload_on_alarm = true,
-    };
-    ESP_ERROR_CHECK(gptimer_set_alarm_action(writetimer, &alarm_config));
-
-    gptimer_enable(writetimer);
+    net_events = xEventGroupCreate();
+    if (STREAM_TRANSPORT_UDP || STREAM_TRANSPORT_COAP || STREAM_TRANSPORT_COAP_OBSERVE)
+    {
+        esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+        ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
+        frame_event_fd = eventfd(0, 0);
+        set_frame_notify_fd(frame_pool, frame_event_fd);
+    }
+    if (STREAM_TRANSPORT_COAP_OBSERVE)
+    {
+        // Observers can register before the Server Registration and the Start Signal, Frames follow with the Measurement
+        coap_audio = init_coap_audio(frame_pool, COAP_PORT, frame_event_fd);
+        if (coap_audio == NULL)
+        {
+            ESP_LOGE(tag_socket, "CoAP Observe Resource failed, Frames are dropped by the Frame Pool");
+        }
+        else
+        {
+            xTaskCreatePinnedToCore(&send_task_observe, "send_task_observe", 8192, NULL, PIPELINE_SEND_PRIORITY, NULL, PIPELINE_NETWORK_CORE);
+        }
+    }
+    if (COAP_CONTROL)
+    {
+        coap_control = init_coap_control(COAP_CONTROL_PORT, frame_pool, bitrate, SENSOR_RATE_HZ, start_measurement);
+        if (coap_control == NULL)
+        {
+            ESP_LOGE(tag_socket, "CoAP Control Resources failed, only the Settings Port is served");
+        }
+    }
+    if (COAP_DISCOVERY)
+    {
+        if (coap_control == NULL || coap_control_discovery(coap_control, enroll_sensor) < 0)
+        {
+            ESP_LOGE(tag_socket, "CoAP Discovery failed");
+            return;
+        }
+        // Same Firmware on every Sensor: the Collector finds it in the All-CoAP-Nodes Group and sets SensorID and Server
+        while (!sensorEnrolled)
+        {
+            coap_control_process(coap_control, 1000, 0, NULL);
+        }
+    }
 
     if(init_udp() < 0)
     {
@@ -603,17 +1615,32 @@ void app_main(void)
     else
     {
         ESP_LOGI(tag_socket, "Register at Server successfull");
+        add_destination(destinations, &server_addr);
+        if (UDP_RAW_SENDER)
+        {
+            udp_raw = init_udp_raw(frame_pool, MULTICAST_TTL);
+            if (udp_raw == NULL)
+            {
+                ESP_LOGE(tag_socket, "Raw UDP Sender failed, using sendto()");
+            }
+        }
+        if(init_multicast() < 0)
+        {
+            ESP_LOGE(tag_socket, "Multicast Setup failed");
+        }
         
         if(obtain_time() > 0)
         {
+            // All Sockets are served by the Event Loop of net_task from now on
+            fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(init_sock, F_SETFL, fcntl(init_sock, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(setting_sock, F_SETFL, fcntl(setting_sock, F_GETFL, 0) | O_NONBLOCK);
+            xTaskCreatePinnedToCore(&net_task, "net_task", 8192, NULL, PIPELINE_SEND_PRIORITY, NULL, PIPELINE_NETWORK_CORE);
 
             ESP_LOGI(tag_debug, "Wait for Serverstart Signal");
-            //Use Setting_Socket to receive Broadcast from Server
-            while(startMeasurement != 1)
-            {
-                recvfrom(setting_sock, &startMeasurement, sizeof(startMeasurement), 0, (struct sockaddr *)&start_addr, &start_addr_len);
-            }
-             
+            //net_task receives the Broadcast from Server on Setting_Socket
+            xEventGroupWaitBits(net_events, NET_START_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+
             gettimeofday(&measuringStart, NULL);
             if(sensorID != 0)
             {
@@ -621,8 +1648,28 @@ void app_main(void)
             }
             
             
-            ESP_ERROR_CHECK(gptimer_start(writetimer)); 
-            xTaskCreate(&send_task_udp, "send_task_udp", 15000, NULL, 0, NULL);
+            // Collect-Task starts the Sensor Timer on its Core
+            xTaskCreatePinnedToCore(&collect_task, "collect_task", 4096, NULL, PIPELINE_COLLECT_PRIORITY, NULL, PIPELINE_ACQUISITION_CORE);
+            if (STREAM_TRANSPORT_COAP)
+            {
+                static const coap_proto_t coap_protos[] = {COAP_PROTO_UDP, COAP_PROTO_TCP, COAP_PROTO_WS, COAP_PROTO_DTLS};
+                static const uint16_t coap_ports[] = {COAP_PORT, COAP_PORT, COAP_WS_PORT, COAP_DTLS_PORT};
+                struct sockaddr_in coap_addr = {
+                    .sin_family = AF_INET,
+                    .sin_port = htons(coap_ports[COAP_STREAM_PROTOCOL]),
+                    .sin_addr.s_addr = COAP_DISCOVERY ? server_addr.sin_addr.s_addr : inet_addr(COAP_SERVERADDRESS),
+                };
+                coap_stream = init_coap_stream(frame_pool, &coap_addr, coap_protos[COAP_STREAM_PROTOCOL], COAP_STREAM_OSCORE,
+                                               frame_event_fd);
+                xTaskCreatePinnedToCore(&send_task_coap, "send_task_coap", 8192, NULL, PIPELINE_SEND_PRIORITY, NULL, PIPELINE_NETWORK_CORE);
+            }
+            else if (STREAM_TRANSPORT_TCP)
+            {
+                struct sockaddr_in tcp_addr = server_addr;
+                tcp_addr.sin_port = htons(TCP_STREAM_PORT);
+                tcp_stream = init_tcp_stream(&tcp_addr);
+                xTaskCreatePinnedToCore(&send_task_tcp, "send_task_tcp", 4096, NULL, PIPELINE_SEND_PRIORITY, NULL, PIPELINE_NETWORK_CORE);
+            }
             ESP_LOGI(tag_debug, "Measurement Started at %s", asctime(localtime(&measuringStart.tv_sec)));
         }
     }
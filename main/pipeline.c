@@ -0,0 +1,114 @@
+/**
+ * @file pipeline.c
+ * @brief Encode-Stage and CPU Load Logging of the Pipeline Stages from their busy Cycles
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+// Custom Headerfiles
+#include "pipeline.h"
+
+static const char *tag_pipeline = "Pipeline";
+static const char *stage_names[STAGE_COUNT] = {"Acquisition", "Collect", "Encode", "Send", "Control"};
+
+pipeline_stats_t pipeline_stats;
+
+void encode_frame(frame_t *frame)
+{
+    uint32_t busyStart;
+    uint32_t *data = frame->data;
+    uint32_t packed = 0;
+    uint read;
+    uint write;
+    bool half;
+
+    if(frame->rawBlocks == 0)
+    {
+        return;
+    }
+    busyStart = pipeline_begin();
+
+    // Raw Blocks are the End of the Frame, the Words in front (Sequence Number) are encoded already. Encoded Blocks are
+    // never longer than raw ones, so write stays behind read
+    read = frame->length - (frame->rawBlocks * (2 + frame->rawSamples));
+    write = read;
+    for(uint block = 0; block < frame->rawBlocks; block++)
+    {
+        // SensorID with Profile and Timestamp
+        data[write] = htonl(data[read]);
+        write++;
+        read++;
+        data[write] = htonl(data[read]);
+        write++;
+        read++;
+
+        half = false;
+        for(uint i = 0; i < frame->rawSamples; i += frame->decimation)
+        {
+            if(frame->sampleBits == 32)
+            {
+                data[write] = htonl(data[read + i]);
+                write++;
+            }
+            else if(!half)
+            {
+                packed = data[read + i] << 16;
+                half = true;
+            }
+            else
+            {
+                data[write] = htonl(packed | (data[read + i] & 0xFFFF));
+                write++;
+                half = false;
+            }
+        }
+
+        // Odd Sample Count: last Word is padded with 0
+        if(half)
+        {
+            data[write] = htonl(packed);
+            write++;
+        }
+        read += frame->rawSamples;
+    }
+
+    frame->length = write;
+    frame->rawBlocks = 0;
+    pipeline_end(STAGE_ENCODE, busyStart);
+}
+
+void log_pipeline_load(void)
+{
+    static uint32_t lastCycles[STAGE_COUNT];
+    static int64_t lastTime = 0;
+    int64_t now = esp_timer_get_time();
+    uint64_t interval;
+    uint32_t cycles;
+
+    if(lastTime != 0)
+    {
+        // Cycles available on one Core in the Interval
+        interval = (uint64_t)(now - lastTime) * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        for(int i = 0; i < STAGE_COUNT; i++)
+        {
+            cycles = pipeline_stats.busyCycles[i] - lastCycles[i];
+            ESP_LOGI(tag_pipeline, "%s on Core %d: %llu.%llu %%", stage_names[i], pipeline_stats.core[i],
+                     (cycles * 100ULL) / interval, ((cycles * 1000ULL) / interval) % 10);
+        }
+    }
+
+    for(int i = 0; i < STAGE_COUNT; i++)
+    {
+        lastCycles[i] = pipeline_stats.busyCycles[i];
+    }
+    lastTime = now;
+}
@@ -29,6 +29,7 @@ ringbuffer_handle_t *init_buffer(uint size)
     buffer->writeIndex = 0;
     buffer->readIndex = 0;
     buffer->size = size;
+    buffer->capacity = size;
     buffer->full = false;
 
     return buffer;
@@ -75,6 +76,21 @@ bool is_full(ringbuffer_handle_t *buffer)
     return buffer->full;
 }
 
+int set_buffer_size(ringbuffer_handle_t *buffer, uint size)
+{
+    if(size < 2 || size > (uint)buffer->capacity || buffer->full || buffer->readIndex != buffer->writeIndex)
+    {
+        return -1;
+    }
+
+    // Start at Index 0, so the next Block fills exactly size Values
+    buffer->writeIndex = 0;
+    buffer->readIndex = 0;
+    buffer->size = size;
+
+    return 1;
+}
+
 void free_buffer(ringbuffer_handle_t *buffer)
 {
     free(buffer->sensValue);
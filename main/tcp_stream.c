@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "lwip/sockets.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "tcp_stream.h"
+
+// Defines
+#define TCP_KEEPALIVE_IDLE_S 5
+#define TCP_KEEPALIVE_INTERVAL_S 1
+#define TCP_KEEPALIVE_COUNT 3
+
+static const char *tag_tcp = "TCP-Stream";
+
+tcp_stream_t *init_tcp_stream(const struct sockaddr_in *addr)
+{
+    tcp_stream_t *stream;
+
+    stream = calloc(1, sizeof(tcp_stream_t));
+    if(stream == NULL)
+    {
+        return NULL;
+    }
+
+    stream->sock = -1;
+    stream->addr = *addr;
+    stream->lastAcked = UINT32_MAX;
+
+    return stream;
+}
+
+int tcp_stream_connect(tcp_stream_t *stream)
+{
+    int option = 1;
+    int flags;
+    int err;
+    socklen_t length = sizeof(err);
+    fd_set writefds;
+    struct timeval timeout = {
+        .tv_sec = TCP_STALL_TIMEOUT_MS / 1000,
+        .tv_usec = (TCP_STALL_TIMEOUT_MS % 1000) * 1000,
+    };
+
+    stream->sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(stream->sock < 0)
+    {
+        ESP_LOGE(tag_tcp, "Unable to create socket: errno %d", errno);
+        return -1;
+    }
+
+    // Frames are written in one Call, so Nagle would only delay them
+    setsockopt(stream->sock, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+    setsockopt(stream->sock, SOL_SOCKET, SO_KEEPALIVE, &option, sizeof(option));
+    option = TCP_KEEPALIVE_IDLE_S;
+    setsockopt(stream->sock, IPPROTO_TCP, TCP_KEEPIDLE, &option, sizeof(option));
+    option = TCP_KEEPALIVE_INTERVAL_S;
+    setsockopt(stream->sock, IPPROTO_TCP, TCP_KEEPINTVL, &option, sizeof(option));
+    option = TCP_KEEPALIVE_COUNT;
+    setsockopt(stream->sock, IPPROTO_TCP, TCP_KEEPCNT, &option, sizeof(option));
+    setsockopt(stream->sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Non-blocking Connect, so an unreachable Server costs at most TCP_CONNECT_TIMEOUT_MS of the Resume Window
+    flags = fcntl(stream->sock, F_GETFL, 0);
+    fcntl(stream->sock, F_SETFL, flags | O_NONBLOCK);
+    err = connect(stream->sock, (struct sockaddr *)&stream->addr, sizeof(stream->addr));
+    if(err < 0 && errno == EINPROGRESS)
+    {
+        FD_ZERO(&writefds);
+        FD_SET(stream->sock, &writefds);
+        timeout.tv_sec = TCP_CONNECT_TIMEOUT_MS / 1000;
+        timeout.tv_usec = (TCP_CONNECT_TIMEOUT_MS % 1000) * 1000;
+        if(select(stream->sock + 1, NULL, &writefds, NULL, &timeout) == 1 &&
+           getsockopt(stream->sock, SOL_SOCKET, SO_ERROR, &err, &length) == 0)
+        {
+            errno = err;
+            err = (err == 0) ? 0 : -1;
+        }
+        else
+        {
+            errno = ETIMEDOUT;
+            err = -1;
+        }
+    }
+    if(err < 0)
+    {
+        ESP_LOGE(tag_tcp, "Connect to %s, %d failed: errno %d", inet_ntoa(stream->addr.sin_addr), ntohs(stream->addr.sin_port), errno);
+        close(stream->sock);
+        stream->sock = -1;
+        return -1;
+    }
+    fcntl(stream->sock, F_SETFL, flags);
+
+    stream->ackBytes = 0;
+    stream->reconnects++;
+    ESP_LOGI(tag_tcp, "Connected to %s, %d", inet_ntoa(stream->addr.sin_addr), ntohs(stream->addr.sin_port));
+
+    return 1;
+}
+
+void tcp_stream_close(tcp_stream_t *stream)
+{
+    if(stream->sock >= 0)
+    {
+        close(stream->sock);
+        stream->sock = -1;
+    }
+}
+
+int tcp_stream_send_frame(tcp_stream_t *stream, frame_t *frame)
+{
+    uint32_t length = htonl(frame->length * sizeof(uint32_t));
+    struct iovec iov[2] = {
+        {.iov_base = &length, .iov_len = sizeof(length)},
+        {.iov_base = frame->data, .iov_len = frame->length * sizeof(uint32_t)},
+    };
+    struct msghdr message = {
+        .msg_iov = iov,
+        .msg_iovlen = 2,
+    };
+    size_t total = iov[0].iov_len + iov[1].iov_len;
+    size_t written = 0;
+    ssize_t err;
+
+    if(stream->sock < 0)
+    {
+        return -1;
+    }
+
+    // Length and Frame in one Call without copying. sendmsg may return early if the Send Buffer is full, continue with the rest
+    while(written < total)
+    {
+        err = sendmsg(stream->sock, &message, 0);
+        if(err <= 0)
+        {
+            ESP_LOGE(tag_tcp, "Send failed! err: %d", errno);
+            return -1;
+        }
+        written += err;
+
+        for(int i = 0; i < 2; i++)
+        {
+            size_t used = ((size_t)err < iov[i].iov_len) ? (size_t)err : iov[i].iov_len;
+            iov[i].iov_base = (uint8_t *)iov[i].iov_base + used;
+            iov[i].iov_len -= used;
+            err -= used;
+        }
+    }
+
+    return 1;
+}
+
+int tcp_stream_poll_ack(tcp_stream_t *stream)
+{
+    ssize_t length;
+    uint32_t ack;
+
+    if(stream->sock < 0)
+    {
+        return -1;
+    }
+
+    while(1)
+    {
+        length = recv(stream->sock, &stream->ackBuffer[stream->ackBytes], sizeof(stream->ackBuffer) - stream->ackBytes, MSG_DONTWAIT);
+        if(length == 0)
+        {
+            ESP_LOGE(tag_tcp, "Connection closed by Server");
+            return -1;
+        }
+        if(length < 0)
+        {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+        }
+
+        stream->ackBytes += length;
+        if(stream->ackBytes == sizeof(stream->ackBuffer))
+        {
+            memcpy(&ack, stream->ackBuffer, sizeof(ack));
+            stream->lastAcked = ntohl(ack);
+            stream->ackBytes = 0;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "lwip/opt.h"
+#include "lwip/sockets.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/tcpip.h"
+
+// Custom Headerfiles
+#include "frame_pool.h"
+#include "udp_raw.h"
+
+#if !LWIP_TCPIP_CORE_LOCKING
+#error "udp_raw.c needs CONFIG_LWIP_TCPIP_CORE_LOCKING to call lwIP from the Send-Task"
+#endif
+
+/**
+ * @brief Called by lwIP/WiFi when the last Reference of the Datagram is gone. Releases the Frame to the Pool
+ *
+ * @param p pbuf_custom of a udp_raw_pbuf
+ */
+static void free_frame_pbuf(struct pbuf *p)
+{
+    struct udp_raw_pbuf *framePbuf = (struct udp_raw_pbuf *)p;
+    udp_raw_t *raw = framePbuf->raw;
+    frame_t *frame = framePbuf->frame;
+
+    xQueueSend(raw->freePbufs, &framePbuf, 0);
+    release_frame(raw->pool, frame);
+}
+
+udp_raw_t *init_udp_raw(frame_pool_handle_t *pool, uint8_t ttl)
+{
+    udp_raw_t *raw;
+
+    raw = calloc(1, sizeof(udp_raw_t));
+    if(raw == NULL)
+    {
+        return NULL;
+    }
+
+    raw->freePbufs = xQueueCreate(UDP_RAW_PBUF_COUNT, sizeof(struct udp_raw_pbuf *));
+    if(raw->freePbufs == NULL)
+    {
+        free(raw);
+        return NULL;
+    }
+
+    for(uint i = 0; i < UDP_RAW_PBUF_COUNT; i++)
+    {
+        struct udp_raw_pbuf *framePbuf = &raw->pbufs[i];
+
+        framePbuf->raw = raw;
+        framePbuf->custom.custom_free_function = free_frame_pbuf;
+        xQueueSend(raw->freePbufs, &framePbuf, 0);
+    }
+
+    LOCK_TCPIP_CORE();
+    raw->pcb = udp_new();
+    if(raw->pcb != NULL)
+    {
+        udp_set_multicast_ttl(raw->pcb, ttl);
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if(raw->pcb == NULL)
+    {
+        vQueueDelete(raw->freePbufs);
+        free(raw);
+        return NULL;
+    }
+
+    raw->pool = pool;
+
+    return raw;
+}
+
+int udp_raw_send_frame(udp_raw_t *raw, frame_t *frame, const struct sockaddr_in *addr)
+{
+    struct udp_raw_pbuf *framePbuf;
+    struct pbuf *p;
+    ip_addr_t ip;
+    uint16_t length;
+    err_t err;
+
+    // pbuf Length is 16 Bit, a larger Frame can not be sent as one Datagram
+    if(frame->length > UINT16_MAX / sizeof(uint32_t))
+    {
+        return -1;
+    }
+    length = frame->length * sizeof(uint32_t);
+
+    if(xQueueReceive(raw->freePbufs, &framePbuf, 0) != pdTRUE)
+    {
+        raw->pbufsExhausted++;
+        return 0;
+    }
+
+    // PBUF_RAW without Header Space: udp_sendto chains its own Header pbuf in front, the Payload is never copied
+    hold_frame(frame);
+    framePbuf->frame = frame;
+    p = pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, &framePbuf->custom, frame->data, length);
+    if(p == NULL)
+    {
+        xQueueSend(raw->freePbufs, &framePbuf, 0);
+        release_frame(raw->pool, frame);
+        return -1;
+    }
+
+    ip_addr_set_ip4_u32(&ip, addr->sin_addr.s_addr);
+
+    // Core Lock instead of the tcpip Mailbox: sent directly from this Task
+    LOCK_TCPIP_CORE();
+    err = udp_sendto(raw->pcb, p, &ip, ntohs(addr->sin_port));
+    UNLOCK_TCPIP_CORE();
+
+    // Drop own Reference, Frame is released when lwIP/WiFi are done with the Datagram
+    pbuf_free(p);
+
+    if(err == ERR_MEM || err == ERR_BUF)
+    {
+        return 0;
+    }
+    if(err != ERR_OK)
+    {
+        return -1;
+    }
+
+    return 1;
+}